@@ -3146,6 +3146,11 @@ int ngsMapLayerDelete(char mapId, LayerH layer)
  *   ZOOM_INCREMENT - Add integer value to zoom level correspondent to scale. May be negative
  *   VIEWPORT_REDUCE_FACTOR - Reduce view size on provided value. Make sense to
  *     reduce number of tiles in map extent. The tiles will be more pixelate
+ *   PREFETCH_TILES - Maximum number of tiles filled ahead of view in pan
+ *     direction or on the next zoom level. Default is 0 - no prefetch
+ *   PREFETCH_MEMORY - Memory limit in Mb of layers data kept for prefetch
+ *     tiles. Size of not yet filled tiles is estimated by filled ones.
+ *     Default is 32, 0 - only PREFETCH_TILES limit is applied
  * @return ngsCode value - COD_SUCCESS if everything is OK
  */
 int ngsMapSetOptions(char mapId, char **options)
@@ -3577,10 +3582,7 @@ int ngsLayerSetSelectionIds(LayerH layer, POINTER_SIZE *ids, int size)
         return outMessage(COD_UNSUPPORTED, _("Layer type is unsupported. Mast be GlFeatureLayer"));
     }
 
-    std::set<GIntBig> selectIds;
-    for(int i = 0; i < size; ++i) {
-        selectIds.insert(ids[i]);
-    }
+    FeatureIDs selectIds(ids, ids + size);
     renderLayerPtr->setSelectedIds(selectIds);
     return COD_SUCCESS;
 }
@@ -3596,10 +3598,7 @@ int ngsLayerSetHideIds(LayerH layer, POINTER_SIZE *ids, int size)
         return outMessage(COD_UNSUPPORTED, _("Layer type is unsupported. Mast be ISelectableFeatureLayer"));
     }
 
-    std::set<GIntBig> hideIds;
-    for(int i = 0; i < size; ++i) {
-        hideIds.insert(ids[i]);
-    }
+    FeatureIDs hideIds(ids, ids + size);
     renderLayerPtr->setHideIds(hideIds);
     return COD_SUCCESS;
 }
@@ -682,6 +682,19 @@ std::string Dataset::options(enum ngsOptionType optionType) const
                "  <Option name='CREATE_OVERVIEWS_TABLE' type='boolean' description='Create empty overviews table' default='NO'/>"
                "  <Option name='CREATE_OVERVIEWS' type='boolean' description='Create overviews table and fill it with overviews. The level should be set by ZOOM_LEVELS option' default='NO'/>"
                "  <Option name='ZOOM_LEVELS' type='string' description='Comma separated list of zoom level' default=''/>"
+               "  <Option name='COMPRESS_TILES' type='boolean' description='Compress overview tiles with deflate' default='NO'/>"
+               "  <Option name='MEMORY_BUDGET' type='float' description='Memory limit in Mb for overviews creation. If exceeded, tiles are flushed to temporary files and merged at the end. 0 - unlimited' default='128'/>"
+               "  <Option name='PYRAMID' type='boolean' description='Tile source geometries only for the most detailed zoom level and build coarser levels from child tiles. Memory budget is not applied' default='NO'/>"
+               "  <Option name='NUM_THREADS' type='integer' description='Worker threads count for overviews creation. Default is number of CPUs or GDAL_NUM_THREADS'/>"
+               "  <Option name='CHECKPOINT_FEATURES' type='integer' description='Flush generated tiles to temporary file and save progress every N features, so interrupted creation can be resumed. Not used with PYRAMID and CLUSTER_POINTS. 0 - disable' default='0'/>"
+               "  <Option name='RESUME' type='boolean' description='Resume interrupted overviews creation from the last checkpoint if options are the same' default='YES'/>"
+               "  <Option name='CLUSTER_POINTS' type='boolean' description='Store point clusters with members count and ids in overviews of point layers instead of every point' default='NO'/>"
+               "  <Option name='CLUSTER_RADIUS' type='float' description='Point cluster size in pixels' default='32'/>"
+               "  <Option name='SIMPLIFY' type='string-select' description='Overview geometry simplification: grid snapping, Douglas-Peucker or Visvalingam-Whyatt with pixel size tolerance' default='GRID'>"
+               "    <Value>GRID</Value>"
+               "    <Value>DP</Value>"
+               "    <Value>VW</Value>"
+               "  </Option>"
                "</LoadOptionList>";
     }
 
@@ -298,6 +298,9 @@ Table *DataStore::createTable(const std::string &name,
 
 void DataStore::close()
 {
+    if(isOpened()) {
+        flushOverviewsTiles();
+    }
     Dataset::close();
     m_disableJournalCounter = 0;
     m_tracksTable = nullptr;
@@ -436,6 +439,25 @@ OGRLayer *DataStore::createEditHistoryTable(const std::string &name)
     return ngw::createEditHistoryTable(m_addsDS, logLayerName);
 }
 
+void DataStore::stopBatchOperation()
+{
+    enableJournal(true);
+    if(!isBatchOperation()) {
+        flushOverviewsTiles();
+    }
+}
+
+void DataStore::flushOverviewsTiles()
+{
+    for(const auto &child : m_children) {
+        FeatureClassOverview *featureClass =
+                dynamic_cast<FeatureClassOverview*>(child.get());
+        if(nullptr != featureClass) {
+            featureClass->flushDirtyTiles();
+        }
+    }
+}
+
 bool DataStore::isBatchOperation() const
 {
     return m_disableJournalCounter > 0;
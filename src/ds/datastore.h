@@ -55,7 +55,7 @@ public:
     virtual bool open(unsigned int openFlags = DatasetBase::defaultOpenFlags,
                       const Options &options = Options()) override;
     virtual void startBatchOperation() override { enableJournal(false); }
-    virtual void stopBatchOperation() override { enableJournal(true); }
+    virtual void stopBatchOperation() override;
     virtual bool isBatchOperation() const override;
 
     virtual FeatureClass *createFeatureClass(const std::string &name,
@@ -120,6 +120,7 @@ protected:
 protected:
     void enableJournal(bool enable);
     bool upgrade(int oldVersion);
+    void flushOverviewsTiles();
 
 protected:
     unsigned char m_disableJournalCounter;
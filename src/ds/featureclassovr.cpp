@@ -22,29 +22,428 @@
 #include "datastore.h"
 #include "featureclassovr.h"
 
+// stl
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+
+#include "catalog/file.h"
+#include "catalog/folder.h"
 #include "map/maptransform.h"
 #include "util/error.h"
+#include "util/settings.h"
+#include "util/stringutil.h"
 
 namespace ngs {
 
 constexpr const char *ZOOM_LEVELS_OPTION = "ZOOM_LEVELS";
 constexpr unsigned short TILE_SIZE = 256; //240; //512;// 160; // Only use for overviews now in pixelSize
 constexpr double WORLD_WIDTH = DEFAULT_BOUNDS_X2.width();
+constexpr const char *MEMORY_BUDGET_OPTION = "MEMORY_BUDGET";
+constexpr const char *COMPRESS_TILES_OPTION = "COMPRESS_TILES";
+constexpr const char *COMPRESS_TILES_KEY = "compress_tiles";
+constexpr const char *PYRAMID_OPTION = "PYRAMID";
+constexpr const char *SIMPLIFY_OPTION = "SIMPLIFY";
+constexpr const char *SIMPLIFY_KEY = "simplify";
+constexpr const char *CLUSTER_POINTS_OPTION = "CLUSTER_POINTS";
+constexpr const char *CLUSTER_POINTS_KEY = "cluster_points";
+constexpr const char *CLUSTER_RADIUS_OPTION = "CLUSTER_RADIUS";
+constexpr const char *CLUSTER_RADIUS_KEY = "cluster_radius";
+constexpr int DEFAULT_CLUSTER_RADIUS = 32; // pixels
+// Part of cluster cell size the quantized cluster centroid may be out of cell
+constexpr double CLUSTER_CELL_TOLERANCE = 0.05;
+// Members of cluster read to check it belongs to the cell
+constexpr size_t CLUSTER_MEMBER_CHECKS = 3;
+constexpr double TILE_QUANTIZE_FACTOR = 0.25; // Quarter of precise pixel
+constexpr int DEFAULT_TILE_CACHE_SIZE = 16; // Mb
+constexpr long DEFAULT_MEMORY_BUDGET = 128; // Mb
+constexpr int DEFAULT_DIRTY_TILES_LIMIT = 256;
+constexpr size_t PARALLEL_TILING_MIN_FEATURES = 32;
+constexpr double PARALLEL_TILING_CHECK_INTERVAL = 0.005; // sec.
+constexpr size_t RUN_RECORD_HEADER_SIZE = 14;
+constexpr const char *NUM_THREADS_OPTION = "NUM_THREADS";
+constexpr size_t PARTITION_BATCH_SIZE = 256;
+constexpr unsigned char PARTITIONS_PER_THREAD = 4;
+constexpr int MAX_NEAREST_FINER_SHIFT = 1;
+// Geometry of more distant coarser levels is too generalized
+constexpr int MAX_NEAREST_COARSER_SHIFT = 2;
+constexpr const char *CHECKPOINT_FEATURES_OPTION = "CHECKPOINT_FEATURES";
+constexpr long DEFAULT_CHECKPOINT_FEATURES = 0; // Disabled
+constexpr const char *RESUME_OPTION = "RESUME";
+constexpr const char *OVR_STATE_KEY = "overviews_state";
+constexpr const char *OVR_STATE_BUILDING = "building";
+constexpr const char *OVR_STATE_READY = "ready";
+constexpr const char *OVR_STATE_FAILED = "failed";
+constexpr const char *OVR_BUILD_OPTIONS_KEY = "overviews_build_options";
+constexpr const char *OVR_CHECKPOINT_FID_KEY = "overviews_checkpoint_fid";
+constexpr const char *OVR_CHECKPOINT_RUNS_KEY = "overviews_checkpoint_runs";
+constexpr const char *OVR_RUNS_SEPARATOR = "|";
+constexpr const char *OVR_PRESENCE_FILTER_KEY = "overviews_presence_filter_";
 
 //------------------------------------------------------------------------------
 // TilingData
 //------------------------------------------------------------------------------
 
+// Batch of features from one spatial partition. Tiles are accumulated in the
+// batch without locks and merged to overview tiles by the caller thread.
 class TilingData : public ThreadData {
 public:
-    TilingData(FeatureClassOverview *featureClass, FeaturePtr feature, bool own) :
-        ThreadData(own), m_feature(feature), m_featureClass(featureClass) {
+    TilingData(const FeatureClassOverview *featureClass,
+               const std::set<unsigned char> &zoomLevels) :
+        ThreadData(false), m_featureClass(featureClass),
+        m_zoomLevels(zoomLevels), m_done(false) {
 
     }
+    const FeatureClassOverview *m_featureClass;
+    std::set<unsigned char> m_zoomLevels;
+    std::vector<FeaturePtr> m_features;
+    std::map<Tile, VectorTile> m_tiles;
+    std::atomic<bool> m_done;
+};
+
+using TilingDataPtr = std::unique_ptr<TilingData>;
+
+//------------------------------------------------------------------------------
+// TileFeatureData
+//------------------------------------------------------------------------------
+
+// Tiling jobs of one tile request. The pool is shared by concurrent requests,
+// so each one waits for own jobs only.
+class TileFeatureJobs {
+public:
+    explicit TileFeatureJobs(size_t count) : m_remaining(count) {}
+    void done() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(--m_remaining == 0) {
+            m_finished.notify_all();
+        }
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this]() { return m_remaining == 0; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+    size_t m_remaining;
+};
+
+class TileFeatureData : public ThreadData {
+public:
+    TileFeatureData(const FeatureClassOverview *featureClass, FeaturePtr feature,
+                    double step, const Tile &tile, const Envelope &extent,
+                    VectorTileItemArray *items, TileFeatureJobs *jobs,
+                    bool own) :
+        ThreadData(own), m_featureClass(featureClass), m_feature(feature),
+        m_step(step), m_tile(tile), m_extent(extent), m_items(items),
+        m_jobs(jobs) {
+
+    }
+    // Data is deleted once processed or dropped by the pool
+    virtual ~TileFeatureData() override {
+        if(nullptr != m_jobs) {
+            m_jobs->done();
+        }
+    }
+    const FeatureClassOverview *m_featureClass;
     FeaturePtr m_feature;
-    FeatureClassOverview *m_featureClass;
+    double m_step;
+    Tile m_tile;
+    Envelope m_extent;
+    VectorTileItemArray *m_items;
+    TileFeatureJobs *m_jobs;
+};
+
+//------------------------------------------------------------------------------
+// PyramidTileData
+//------------------------------------------------------------------------------
+
+class PyramidTileData : public ThreadData {
+public:
+    PyramidTileData(const FeatureClassOverview *featureClass, const Tile &tile,
+                    const std::vector<VectorTileRef> &children,
+                    VectorTile *vtile, bool own) :
+        ThreadData(own), m_featureClass(featureClass), m_tile(tile),
+        m_children(children), m_vtile(vtile) {
+
+    }
+    const FeatureClassOverview *m_featureClass;
+    Tile m_tile;
+    std::vector<VectorTileRef> m_children;
+    VectorTile *m_vtile;
+};
+
+//------------------------------------------------------------------------------
+// OverviewRunReader
+//------------------------------------------------------------------------------
+
+/**
+ * @brief The OverviewRunReader class. Sequentially reads tiles from the sorted
+ * run file flushed to disk during overviews creation.
+ */
+class OverviewRunReader {
+public:
+    explicit OverviewRunReader(const std::string &path) :
+        m_fp(VSIFOpenL(path.c_str(), "rb")),
+        m_tile({0, 0, 0, 0}) {}
+    ~OverviewRunReader() {
+        if(nullptr != m_fp) {
+            VSIFCloseL(m_fp);
+        }
+    }
+    bool next();
+    const Tile &tile() const { return m_tile; }
+    size_t recordSize() const {
+        return RUN_RECORD_HEADER_SIZE + m_data.size();
+    }
+    VectorTile vectorTile();
+
+private:
+    VSILFILE *m_fp;
+    Tile m_tile;
+    std::vector<GByte> m_data;
 };
 
+using OverviewRunReaderPtr = std::unique_ptr<OverviewRunReader>;
+
+bool OverviewRunReader::next()
+{
+    if(nullptr == m_fp) {
+        return false;
+    }
+
+    GByte header[RUN_RECORD_HEADER_SIZE];
+    if(VSIFReadL(header, RUN_RECORD_HEADER_SIZE, 1, m_fp) != 1) {
+        return false;
+    }
+
+    Buffer buff(header, RUN_RECORD_HEADER_SIZE, false);
+    m_tile.x = static_cast<int>(buff.getULong());
+    m_tile.y = static_cast<int>(buff.getULong());
+    m_tile.z = buff.getByte();
+    m_tile.crossExtent = static_cast<char>(buff.getByte());
+    GUInt32 size = buff.getULong();
+
+    m_data.resize(size);
+    return size == 0 || VSIFReadL(m_data.data(), size, 1, m_fp) == 1;
+}
+
+VectorTile OverviewRunReader::vectorTile()
+{
+    VectorTile vtile;
+    Buffer buff(m_data.data(), static_cast<int>(m_data.size()), false);
+    vtile.load(buff, ngsTileOrigin(m_tile));
+    return vtile;
+}
+
+//------------------------------------------------------------------------------
+// VectorTileCache
+//------------------------------------------------------------------------------
+
+// Overview tiles are stored without cross extent flag.
+static Tile cacheKey(const Tile &tile)
+{
+    Tile key = tile;
+    key.crossExtent = 0;
+    return key;
+}
+
+VectorTileCache::VectorTileCache(size_t maxSize) :
+    m_size(0),
+    m_maxSize(maxSize),
+    m_hits(0),
+    m_misses(0),
+    m_generation(0)
+{
+}
+
+VectorTilePtr VectorTileCache::get(const Tile &tile)
+{
+    MutexHolder holder(m_mutex);
+    auto it = m_index.find(cacheKey(tile));
+    if(it == m_index.end()) {
+        m_misses++;
+        return VectorTilePtr();
+    }
+
+    // Move to the front of the list as most recently used
+    m_items.splice(m_items.begin(), m_items, it->second);
+    m_hits++;
+    return it->second->vtile;
+}
+
+/**
+ * @brief VectorTileCache::generation Returns the counter changed on each
+ * remove or clear. Capture it before reading a tile from the storage and pass
+ * to put, so the tile changed meanwhile is not cached.
+ * @return Current generation.
+ */
+GUIntBig VectorTileCache::generation() const
+{
+    MutexHolder holder(m_mutex);
+    return m_generation;
+}
+
+/**
+ * @brief VectorTileCache::put Puts the tile to the cache.
+ * @param tile Tile key.
+ * @param vtile Tile data.
+ * @param generation Cache generation captured before the tile was read.
+ * @return False if the tile is too large or was invalidated since the read.
+ */
+bool VectorTileCache::put(const Tile &tile, VectorTilePtr vtile,
+                          GUIntBig generation)
+{
+    if(!vtile) {
+        return false;
+    }
+
+    size_t size = vtile->memorySize();
+    if(size > m_maxSize) {
+        return false;
+    }
+
+    Tile key = cacheKey(tile);
+    MutexHolder holder(m_mutex);
+    if(generation != m_generation) {
+        return false;
+    }
+
+    auto it = m_index.find(key);
+    if(it != m_index.end()) {
+        m_size -= it->second->size;
+        m_items.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_items.push_front({key, vtile, size});
+    m_index[key] = m_items.begin();
+    m_size += size;
+
+    while(m_size > m_maxSize && !m_items.empty()) {
+        const CacheItem &last = m_items.back();
+        m_size -= last.size;
+        m_index.erase(last.tile);
+        m_items.pop_back();
+    }
+    return true;
+}
+
+bool VectorTileCache::contains(const Tile &tile) const
+{
+    MutexHolder holder(m_mutex);
+    return m_index.find(cacheKey(tile)) != m_index.end();
+}
+
+void VectorTileCache::remove(const Tile &tile)
+{
+    MutexHolder holder(m_mutex);
+    auto it = m_index.find(cacheKey(tile));
+    if(it != m_index.end()) {
+        m_size -= it->second->size;
+        m_items.erase(it->second);
+        m_index.erase(it);
+    }
+    m_generation++;
+}
+
+void VectorTileCache::clear()
+{
+    MutexHolder holder(m_mutex);
+    m_items.clear();
+    m_index.clear();
+    m_size = 0;
+    m_generation++;
+}
+
+//------------------------------------------------------------------------------
+// TilePresenceFilter
+//------------------------------------------------------------------------------
+
+// About 1% false positives
+constexpr size_t PRESENCE_BITS_PER_TILE = 10;
+constexpr unsigned char PRESENCE_HASH_COUNT = 7;
+
+static void tileKeyHashes(int x, int y, GUIntBig &h1, GUIntBig &h2)
+{
+    // splitmix64 finalizer
+    GUIntBig h = (static_cast<GUIntBig>(static_cast<GUInt32>(x)) << 32) |
+            static_cast<GUInt32>(y);
+    h += 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    h1 = h & 0xFFFFFFFFULL;
+    h2 = (h >> 32) | 1;
+}
+
+TilePresenceFilter::TilePresenceFilter(size_t tileCount) :
+    m_bits((std::max(tileCount, static_cast<size_t>(1)) *
+            PRESENCE_BITS_PER_TILE + 63) / 64, 0),
+    m_hashCount(PRESENCE_HASH_COUNT)
+{
+}
+
+void TilePresenceFilter::add(int x, int y)
+{
+    GUIntBig h1, h2;
+    tileKeyHashes(x, y, h1, h2);
+    GUIntBig bitCount = m_bits.size() * 64;
+    for(unsigned char i = 0; i < m_hashCount; ++i) {
+        GUIntBig bit = (h1 + i * h2) % bitCount;
+        m_bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+bool TilePresenceFilter::mayContain(int x, int y) const
+{
+    if(m_bits.empty()) {
+        return true;
+    }
+
+    GUIntBig h1, h2;
+    tileKeyHashes(x, y, h1, h2);
+    GUIntBig bitCount = m_bits.size() * 64;
+    for(unsigned char i = 0; i < m_hashCount; ++i) {
+        GUIntBig bit = (h1 + i * h2) % bitCount;
+        if(!(m_bits[bit / 64] & (1ULL << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BufferPtr TilePresenceFilter::save() const
+{
+    BufferPtr buff(new Buffer);
+    buff->put(static_cast<GByte>(m_hashCount));
+    buff->put(static_cast<GUInt32>(m_bits.size()));
+    for(GUIntBig word : m_bits) {
+        buff->put(word);
+    }
+    return buff;
+}
+
+bool TilePresenceFilter::load(Buffer &buffer)
+{
+    if(buffer.size() < 5) {
+        return false;
+    }
+    m_hashCount = buffer.getByte();
+    GUInt32 size = buffer.getULong();
+    if(static_cast<size_t>(buffer.size()) < 5 + size * sizeof(GUIntBig)) {
+        m_bits.clear();
+        return false;
+    }
+    m_bits.resize(size);
+    for(GUInt32 i = 0; i < size; ++i) {
+        m_bits[i] = buffer.getUBig();
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
 // FeatureClass
 //------------------------------------------------------------------------------
@@ -55,15 +454,53 @@ FeatureClassOverview::FeatureClassOverview(OGRLayer *layer,
                                            const std::string &name) :
     FeatureClass(layer, parent, type, name),
     m_ovrTable(nullptr),
-    m_creatingOvr(false)
+    m_creatingOvr(false),
+    m_compressTiles(false),
+    m_simplifyType(GEOSGeometryWrap::SimplifyType::GRID),
+    m_clusterPoints(false),
+    m_clusterRadius(DEFAULT_CLUSTER_RADIUS),
+    m_ovrReady(true),
+    m_tileCache(static_cast<size_t>(Settings::instance().getInteger(
+                    "common/overviews_cache_size", DEFAULT_TILE_CACHE_SIZE)) *
+                1024 * 1024),
+    m_dirtyTilesLimit(static_cast<size_t>(Settings::instance().getInteger(
+                          "common/overviews_dirty_tiles",
+                          DEFAULT_DIRTY_TILES_LIMIT))),
+    m_genTilesSize(0),
+    m_memoryBudget(0),
+    m_checkpointFeatures(0),
+    m_checkpointFid(-1),
+    m_checkpointRuns(0),
+    m_presenceLoaded(false),
+    m_presenceChanged(false),
+    m_pyramidBuild(false)
 {
     if(nullptr != m_layer) {
         fillZoomLevels();
+        m_compressTiles = toBool(property(COMPRESS_TILES_KEY, "OFF",
+                                          NG_ADDITIONS_KEY));
+        m_simplifyType = GEOSGeometryWrap::simplifyTypeFromString(
+                    property(SIMPLIFY_KEY, "GRID", NG_ADDITIONS_KEY));
+        m_clusterPoints = toBool(property(CLUSTER_POINTS_KEY, "OFF",
+                                          NG_ADDITIONS_KEY));
+        m_clusterRadius = CPLAtof(property(CLUSTER_RADIUS_KEY,
+                                           std::to_string(DEFAULT_CLUSTER_RADIUS),
+                                           NG_ADDITIONS_KEY).c_str());
+        // Interrupted or failed build leaves incomplete overviews
+        m_ovrReady = property(OVR_STATE_KEY, OVR_STATE_READY,
+                              NG_ADDITIONS_KEY) == OVR_STATE_READY;
     }
 
+    m_tilingPool.init(getNumberThreads(), tileFeatureThreadFunc);
     hasTilesTable();
 }
 
+FeatureClassOverview::~FeatureClassOverview()
+{
+    // Pool workers still access the pool while exiting.
+    m_tilingPool.waitComplete(Progress(), PARALLEL_TILING_CHECK_INTERVAL);
+}
+
 bool FeatureClassOverview::onRowsCopied(const TablePtr srcTable,
                                         const Progress &progress,
                                         const Options &options)
@@ -78,6 +515,10 @@ bool FeatureClassOverview::onRowsCopied(const TablePtr srcTable,
 
 bool FeatureClassOverview::hasOverviews() const
 {
+    if(!m_ovrReady) {
+        return false;
+    }
+
     if(nullptr != m_ovrTable) {
         return true;
     }
@@ -144,20 +585,207 @@ FeaturePtr FeatureClassOverview::getTileFeature(const Tile &tile)
     return out;
 }
 
-VectorTile FeatureClassOverview::getTileInternal(const Tile &tile)
+OverviewTileStore *FeatureClassOverview::tileStore()
+{
+    // Called from tiling and render threads
+    MutexHolder holder(m_tileStoreMutex);
+    if(!m_tileStore) {
+        DataStore * const parentDS = dynamic_cast<DataStore*>(m_parent);
+        if(nullptr == parentDS || !hasTilesTable()) {
+            return nullptr;
+        }
+        m_tileStore.reset(new OverviewTileStore(parentDS->m_addsDS.get(),
+                                                m_ovrTable->GetName()));
+    }
+    return m_tileStore->isOpened() ? m_tileStore.get() : nullptr;
+}
+
+VectorTile FeatureClassOverview::loadTile(const Tile &tile)
 {
     VectorTile vtile;
-    FeaturePtr ovrTile = getTileFeature(tile);
-    if(ovrTile) {
-        int size = 0;
-        GByte *data = ovrTile->GetFieldAsBinary(ovrTile->GetFieldIndex(OVR_TILE_KEY),
-                                                &size);
-        Buffer buff(data, size, false);
-        vtile.load(buff);
+    std::vector<GByte> data;
+    if(readTileData(tile, data) && !data.empty()) {
+        Buffer buff(data.data(), static_cast<int>(data.size()), false);
+        vtile.load(buff, ngsTileOrigin(tile));
+    }
+    return vtile;
+}
+
+VectorTilePtr FeatureClassOverview::getTileInternal(const Tile &tile)
+{
+    // Edits invalidate the cache after the pending tile is set, so taking the
+    // generation first keeps the tile read below from hiding the edit.
+    GUIntBig generation = m_tileCache.generation();
+
+    // Edited tiles not yet written to the overviews table
+    VectorTile dirtyTile;
+    if(getDirtyTile(tile, dirtyTile)) {
+        return std::make_shared<const VectorTile>(std::move(dirtyTile));
+    }
+
+    // Most of tiles of sparse layers are not stored
+    if(!tileMayExist(tile)) {
+        return std::make_shared<const VectorTile>();
+    }
+
+    VectorTilePtr vtile = m_tileCache.get(tile);
+    if(vtile) {
+        return vtile;
     }
+
+    vtile = std::make_shared<const VectorTile>(loadTile(tile));
+
+    // Missing tiles are cached too, as they are requested as often as others.
+    m_tileCache.put(tile, vtile, generation);
     return vtile;
 }
 
+/**
+ * @brief FeatureClassOverview::getNearestTile Gets tile from the closest
+ * stored zoom level. Tile of coarser level is sub-clipped to the requested
+ * tile, tiles of finer level are merged and generalized as in pyramid build.
+ * On equal distance coarser level is used as it needs only one tile read.
+ * Built tile is cached under the requested tile key.
+ * @param tile Tile to get.
+ * @return Tile or null if no stored zoom level is close enough, such tile is
+ * tiled on the fly.
+ */
+VectorTilePtr FeatureClassOverview::getNearestTile(const Tile &tile)
+{
+    auto upper = m_zoomLevels.lower_bound(tile.z);
+    if(upper != m_zoomLevels.end() && *upper == tile.z) {
+        return getTileInternal(tile);
+    }
+
+    int finerShift = upper != m_zoomLevels.end() ? *upper - tile.z : 255;
+    int coarserShift = upper != m_zoomLevels.begin() ?
+                tile.z - *std::prev(upper) : 255;
+    bool useFiner = finerShift <= MAX_NEAREST_FINER_SHIFT &&
+            (finerShift < coarserShift ||
+             coarserShift > MAX_NEAREST_COARSER_SHIFT);
+    if(!useFiner && coarserShift > MAX_NEAREST_COARSER_SHIFT) {
+        return VectorTilePtr();
+    }
+
+    // Taken before the stored tiles read, see getTileInternal
+    GUIntBig generation = m_tileCache.generation();
+    VectorTilePtr cached = m_tileCache.get(tile);
+    if(cached) {
+        return cached;
+    }
+
+    VectorTile vtile;
+    if(useFiner) {
+        std::vector<std::pair<Tile, VectorTilePtr>> children;
+        int count = 1 << finerShift;
+        for(int x = 0; x < count; ++x) {
+            for(int y = 0; y < count; ++y) {
+                Tile child = {(tile.x << finerShift) + x,
+                              (tile.y << finerShift) + y,
+                              static_cast<unsigned char>(tile.z + finerShift),
+                              tile.crossExtent};
+                VectorTilePtr childTile = getTileInternal(child);
+                if(childTile->isValid() && !childTile->empty()) {
+                    children.emplace_back(child, childTile);
+                }
+            }
+        }
+
+        std::vector<VectorTileRef> childPtrs;
+        for(const auto &child : children) {
+            childPtrs.push_back(std::make_pair(child.first,
+                                               child.second.get()));
+        }
+        buildPyramidTile(tile, childPtrs, vtile);
+    }
+    else {
+        Tile parent = {tile.x >> coarserShift, tile.y >> coarserShift,
+                       static_cast<unsigned char>(tile.z - coarserShift),
+                       tile.crossExtent};
+        VectorTilePtr parentTile = getTileInternal(parent);
+        if(parentTile->isValid() && !parentTile->empty()) {
+            clipParentTile(tile, parent, *parentTile, vtile);
+        }
+    }
+
+    VectorTilePtr out = std::make_shared<const VectorTile>(std::move(vtile));
+    m_tileCache.put(tile, out, generation);
+    return out;
+}
+
+/**
+ * @brief FeatureClassOverview::removeNearestTiles Removes cached tiles of not
+ * stored zoom levels, which may be built from the stored tile.
+ * @param tile Stored tile.
+ */
+void FeatureClassOverview::removeNearestTiles(const Tile &tile)
+{
+    for(int shift = 1; shift <= MAX_NEAREST_FINER_SHIFT && shift <= tile.z;
+        ++shift) {
+        unsigned char zoom = static_cast<unsigned char>(tile.z - shift);
+        if(m_zoomLevels.find(zoom) == m_zoomLevels.end()) {
+            m_tileCache.remove({tile.x >> shift, tile.y >> shift, zoom, 0});
+        }
+    }
+
+    for(int shift = 1; shift <= MAX_NEAREST_COARSER_SHIFT; ++shift) {
+        unsigned char zoom = static_cast<unsigned char>(tile.z + shift);
+        if(m_zoomLevels.find(zoom) != m_zoomLevels.end()) {
+            continue;
+        }
+        int count = 1 << shift;
+        for(int x = 0; x < count; ++x) {
+            for(int y = 0; y < count; ++y) {
+                m_tileCache.remove({(tile.x << shift) + x,
+                                    (tile.y << shift) + y, zoom, 0});
+            }
+        }
+    }
+}
+
+/**
+ * @brief FeatureClassOverview::clipParentTile Clips items of coarser zoom
+ * level tile to the tile extent. Geometry is not generalized again.
+ * @param tile Tile to fill.
+ * @param parentTile Tile of coarser zoom level covering the tile.
+ * @param parent Parent tile data.
+ * @param vtile Output tile.
+ */
+void FeatureClassOverview::clipParentTile(const Tile &tile,
+                                          const Tile &parentTile,
+                                          const VectorTile &parent,
+                                          VectorTile &vtile) const
+{
+    OGRRawPoint origin = ngsTileOrigin(parentTile);
+    std::map<FeatureIdSet, std::vector<VectorTileItemRef>> features;
+    for(const auto &item : parent.items()) {
+        if(!item.ids().empty()) {
+            features[item.ids()].push_back(std::make_pair(&item, origin));
+        }
+    }
+
+    OGRwkbGeometryType type = geometryType();
+    Envelope ext = tileEnvelope(tile);
+    ext.resize(TILE_RESIZE);
+
+    for(const auto &feature : features) {
+        GEOSGeometryPtr geom = GEOSGeometryWrap::createFromTileItems(
+                    feature.second, type);
+        if(!geom || !geom->isValid()) {
+            continue;
+        }
+
+        VectorTileItemArray items = tileGeometry(*feature.first.begin(), geom,
+                                                 tile, ext);
+        for(auto &item : items) {
+            for(auto id : feature.first) {
+                item.addId(id);
+            }
+        }
+        vtile.add(items, false);
+    }
+}
+
 bool FeatureClassOverview::setTileFeature(FeaturePtr tile)
 {
     if(!hasTilesTable()) {
@@ -178,151 +806,471 @@ bool FeatureClassOverview::createTileFeature(FeaturePtr tile)
     return m_ovrTable->CreateFeature(tile) == OGRERR_NONE;
 }
 
-bool FeatureClassOverview::tilingDataJobThreadFunc(ThreadData *threadData)
+void FeatureClassOverview::tileFeatureZooms(FeaturePtr feature,
+                                            const std::set<unsigned char> &zoomLevels,
+                                            std::map<Tile, VectorTile> &tiles) const
 {
-    TilingData *data = static_cast<TilingData*>(threadData);
     // Get tiles for geometry
-    OGRGeometry *geom = data->m_feature->GetGeometryRef();
+    OGRGeometry *geom = feature->GetGeometryRef();
     if(nullptr == geom) {
-        return true;
+        return;
     }
 
     GEOSGeometryPtr geosGeom(new GEOSGeometryWrap(geom));
-    GIntBig fid = data->m_feature->GetFID();
+    GIntBig fid = feature->GetFID();
 
-    OGREnvelope env;
-    geom->getEnvelope(&env);
     bool precisePixelSize = !(OGR_GT_Flatten(geom->getGeometryType()) == wkbPoint ||
                               OGR_GT_Flatten(geom->getGeometryType()) == wkbMultiPoint);
 
-    auto zoomLevels = data->m_featureClass->zoomLevels();
     for(auto it = zoomLevels.rbegin(); it != zoomLevels.rend(); ++it) {
         unsigned char zoomLevel = *it;
-        CPLDebug("ngstore", "tilingDataJobThreadFunc for zoom %d", zoomLevel);
-        Envelope extent = extraExtentForZoom(zoomLevel, env);
-
-        std::vector<TileItem> items = MapTransform::getTilesForExtent(
-                    extent, zoomLevel, false, true);
+        std::vector<TileItem> items = MapTransform::getTilesForGeometry(
+                    *geom, zoomLevel, extraSizeForZoom(zoomLevel), true);
 
         double step = FeatureClassOverview::pixelSize(zoomLevel, precisePixelSize);
-        geosGeom->simplify(step);
+        geosGeom->simplify(step, m_simplifyType);
         for(auto tileItem : items) {
             Envelope ext = tileItem.env;
             ext.resize(TILE_RESIZE);
 
-            auto vItems = data->m_featureClass->tileGeometry(fid, geosGeom, ext);
-            data->m_featureClass->addOverviewItem(tileItem.tile, vItems);
+            auto vItems = tileGeometry(fid, geosGeom, tileItem.tile, ext);
+            if(!vItems.empty()) {
+                tiles[tileItem.tile].add(vItems, true);
+            }
         }
     }
-
-    return true;
 }
 
-bool FeatureClassOverview::createOverviews(const Progress &progress, const Options &options)
+bool FeatureClassOverview::tilingDataJobThreadFunc(ThreadData *threadData)
 {
-    CPLDebug("ngstore", "start create overviews");
-    m_genTiles.clear();
-    bool force = options.asBool("FORCE", false);
-    if(!force && hasOverviews()) {
-        return true;
+    TilingData *data = static_cast<TilingData*>(threadData);
+    for(const FeaturePtr &feature : data->m_features) {
+        data->m_featureClass->tileFeatureZooms(feature, data->m_zoomLevels,
+                                               data->m_tiles);
     }
+    data->m_features.clear();
+    data->m_done = true;
+    return true;
+}
 
-    DataStore *parentDS = dynamic_cast<DataStore*>(m_parent);
-    if(nullptr == parentDS) {
-        progress.onProgress(COD_CREATE_FAILED, 0.0,
-                            _("Unsupported feature class"));
-        return errorMessage(_("Unsupported feature class"));
+/**
+ * @brief FeatureClassOverview::tileFeatures Tiles features in identifiers order
+ * with the thread pool. Features are grouped to batches by spatial partitions
+ * of layer extent, so batch tiles are compact. If checkpoints are enabled the
+ * generated tiles are flushed to a run every m_checkpointFeatures features
+ * and the runs are saved together with the last tiled feature identifier.
+ * Features up to m_checkpointFid are skipped.
+ * @param progress Progress to report and check for cancel.
+ * @param threadCount Thread count.
+ * @return False if canceled or checkpoint failed.
+ */
+bool FeatureClassOverview::tileFeatures(const Progress &progress,
+                                        unsigned char threadCount)
+{
+    auto zoomLevels = m_zoomLevels;
+    if(m_pyramidBuild) {
+        // Coarser zoom levels are built from tiles of the most detailed one
+        zoomLevels = { *m_zoomLevels.rbegin() };
     }
 
-    if(nullptr == m_ovrTable) {
-        m_ovrTable = parentDS->getOverviewsTable(name());
-    }
+    Envelope layerExtent = extent();
+    int gridSize = std::max(1, static_cast<int>(std::ceil(std::sqrt(
+                        threadCount * PARTITIONS_PER_THREAD))));
+    double minCellSize = std::numeric_limits<double>::epsilon();
+    double cellWidth = std::max(layerExtent.width() / gridSize, minCellSize);
+    double cellHeight = std::max(layerExtent.height() / gridSize, minCellSize);
 
-    if(nullptr == m_ovrTable) {
-        m_ovrTable = parentDS->createOverviewsTable(name());
-    }
-    else {
-        parentDS->clearOverviewsTable(name());
-    }
+    std::vector<TilingDataPtr> partitions(
+                static_cast<size_t>(gridSize * gridSize));
+    std::list<TilingDataPtr> queued;
 
-    // Drop index
-    parentDS->dropOverviewsTableIndex(name());
+    CPLDebug("ngstore", "fill pool create overviews, %d partitions",
+             gridSize * gridSize);
+    ThreadPool threadPool;
+    threadPool.init(threadCount, tilingDataJobThreadFunc);
 
-    // Fill overview layer with data
-    std::string zoomLevelListStr = options.asString(ZOOM_LEVELS_OPTION, "");
-    fillZoomLevels(zoomLevelListStr);
-    if(m_zoomLevels.empty()) {
-        return true;
+    if(m_checkpointFid >= 0) {
+        setAttributeFilter(CPLSPrintf("FID > " CPL_FRMT_GIB, m_checkpointFid));
     }
 
-    setProperty("zoom_levels", zoomLevelListStr, NG_ADDITIONS_KEY);
-
-    // Tile and simplify geometry
-    progress.onProgress(COD_IN_PROCESS, 0.0,
-                        _("Start tiling and simplifying geometry"));
-
-    // Multithreaded thread pool
-    CPLDebug("ngstore", "fill pool create overviews");
-    ThreadPool threadPool;
-    threadPool.init(getNumberThreads(), tilingDataJobThreadFunc);
-    emptyFields(true);
-    reset();
-
+    bool result = true;
+    GIntBig lastFid = m_checkpointFid;
+    size_t checkpointCounter = 0;
     FeaturePtr feature;
     while((feature = nextFeature())) {
-        threadPool.addThreadData(new TilingData(this, feature, true));
-    }
+        if(m_checkpointFeatures > 0 &&
+           ++checkpointCounter >= m_checkpointFeatures) {
+            checkpointCounter = 0;
+            result = checkpoint(progress, threadPool, partitions, queued,
+                                lastFid);
+            if(!result) {
+                break;
+            }
+        }
+        lastFid = feature->GetFID();
+
+        OGRGeometry *geom = feature->GetGeometryRef();
+        if(nullptr == geom) {
+            continue;
+        }
+
+        OGREnvelope env;
+        geom->getEnvelope(&env);
+        int col = static_cast<int>(((env.MinX + env.MaxX) * 0.5 -
+                                    layerExtent.minX()) / cellWidth);
+        int row = static_cast<int>(((env.MinY + env.MaxY) * 0.5 -
+                                    layerExtent.minY()) / cellHeight);
+        col = std::min(std::max(col, 0), gridSize - 1);
+        row = std::min(std::max(row, 0), gridSize - 1);
+
+        TilingDataPtr &partition = partitions[static_cast<size_t>(row * gridSize + col)];
+        if(!partition) {
+            partition.reset(new TilingData(this, zoomLevels));
+        }
+        partition->m_features.push_back(feature);
+        if(partition->m_features.size() >= PARTITION_BATCH_SIZE) {
+            threadPool.addThreadData(partition.get());
+            queued.push_back(std::move(partition));
+            mergeTilingData(queued);
+        }
+    }
+
+    if(result) {
+        if(m_checkpointFeatures > 0) {
+            result = checkpoint(progress, threadPool, partitions, queued,
+                                lastFid);
+        }
+        else {
+            queuePartitions(threadPool, partitions, queued);
+            threadPool.waitComplete(progress);
+            mergeTilingData(queued);
+            result = queued.empty();
+        }
+    }
+
+    threadPool.clearThreadData();
+    setAttributeFilter();
+    return result;
+}
+
+void FeatureClassOverview::queuePartitions(ThreadPool &threadPool,
+                                           std::vector<TilingDataPtr> &partitions,
+                                           std::list<TilingDataPtr> &queued)
+{
+    for(auto &partition : partitions) {
+        if(partition && !partition->m_features.empty()) {
+            threadPool.addThreadData(partition.get());
+            queued.push_back(std::move(partition));
+        }
+    }
+}
+
+/**
+ * @brief FeatureClassOverview::checkpoint Tiles all collected features, flushes
+ * generated tiles to a run and saves the runs list with the last tiled feature
+ * identifier. Interrupted build resumes with the saved runs.
+ * @param progress Progress to report and check for cancel.
+ * @param threadPool Tiling thread pool.
+ * @param partitions Partially filled batches.
+ * @param queued Batches added to thread pool.
+ * @param lastFid The last tiled feature identifier.
+ * @return False if canceled or save failed.
+ */
+bool FeatureClassOverview::checkpoint(const Progress &progress,
+                                      ThreadPool &threadPool,
+                                      std::vector<TilingDataPtr> &partitions,
+                                      std::list<TilingDataPtr> &queued,
+                                      GIntBig lastFid)
+{
+    queuePartitions(threadPool, partitions, queued);
+    threadPool.waitComplete(progress);
+    mergeTilingData(queued);
+    if(!queued.empty()) {
+        // Canceled
+        return false;
+    }
+
+    if(!flushOverviewRun()) {
+        return errorMessage(_("Failed to save overview tiles checkpoint. %s"),
+                            CPLGetLastErrorMsg());
+    }
+
+    CPLDebug("ngstore", "Checkpoint " CPL_FRMT_GIB " with %ld runs", lastFid,
+             static_cast<long>(m_ovrRuns.size()));
+
+    // Runs are saved first. If interrupted in between, features are tiled
+    // again and duplicated items are merged.
+    std::string runs;
+    for(const auto &path : m_ovrRuns) {
+        if(!runs.empty()) {
+            runs += OVR_RUNS_SEPARATOR;
+        }
+        runs += path;
+    }
+    setProperty(OVR_CHECKPOINT_RUNS_KEY, runs, NG_ADDITIONS_KEY);
+    setProperty(OVR_CHECKPOINT_FID_KEY, std::to_string(lastFid),
+                NG_ADDITIONS_KEY);
+    m_checkpointRuns = m_ovrRuns.size();
+    m_checkpointFid = lastFid;
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::mergeTilingData Merges tiles of finished batches
+ * to generated tiles and removes the batches from list.
+ * @param queued Batches added to thread pool.
+ */
+void FeatureClassOverview::mergeTilingData(std::list<std::unique_ptr<TilingData>> &queued)
+{
+    auto it = queued.begin();
+    while(it != queued.end()) {
+        if(!(*it)->m_done) {
+            ++it;
+            continue;
+        }
+
+        for(const auto &tile : (*it)->m_tiles) {
+            addGenTileItems(tile.first, tile.second.items());
+        }
+        it = queued.erase(it);
+    }
+}
+
+bool FeatureClassOverview::createOverviews(const Progress &progress, const Options &options)
+{
+    CPLDebug("ngstore", "start create overviews");
+    bool force = options.asBool("FORCE", false);
+    if(!force && hasOverviews()) {
+        return true;
+    }
+
+    m_genTiles.clear();
+    {
+        // Overviews are rebuilt from scratch, pending edits are not needed.
+        MutexHolder holder(m_dirtyTilesMutex);
+        m_dirtyTiles.clear();
+    }
+    m_tileCache.clear();
+    clearPresenceFilters();
+
+    DataStore *parentDS = dynamic_cast<DataStore*>(m_parent);
+    if(nullptr == parentDS) {
+        progress.onProgress(COD_CREATE_FAILED, 0.0,
+                            _("Unsupported feature class"));
+        return errorMessage(_("Unsupported feature class"));
+    }
+
+    std::string zoomLevelListStr = options.asString(ZOOM_LEVELS_OPTION, "");
+    std::string simplifyStr = options.asString(SIMPLIFY_OPTION, "GRID");
+    bool compressTiles = options.asBool(COMPRESS_TILES_OPTION, false);
+
+    // Checkpoints are saved for tiling in feature identifiers order. Point
+    // clusters and pyramid are built in memory at once.
+    OGRwkbGeometryType type = OGR_GT_Flatten(geometryType());
+    bool clusterPointsBuild = options.asBool(CLUSTER_POINTS_OPTION, false) &&
+            (type == wkbPoint || type == wkbMultiPoint);
+    bool inMemoryBuild = clusterPointsBuild ||
+            options.asBool(PYRAMID_OPTION, false);
+    m_checkpointFeatures = inMemoryBuild ? 0 : static_cast<size_t>(
+                std::max(0L, options.asLong(CHECKPOINT_FEATURES_OPTION,
+                                            DEFAULT_CHECKPOINT_FEATURES)));
+    std::string buildOptions = zoomLevelListStr + ";" + simplifyStr + ";" +
+            fromBool(compressTiles);
+
+    if(nullptr == m_ovrTable) {
+        m_ovrTable = parentDS->getOverviewsTable(name());
+    }
+
+    // Runs saved at checkpoint of interrupted build
+    char **runsList = CSLTokenizeString2(
+                property(OVR_CHECKPOINT_RUNS_KEY, "", NG_ADDITIONS_KEY).c_str(),
+                OVR_RUNS_SEPARATOR, 0);
+    std::vector<std::string> checkpointRuns = fillStringList(runsList);
+    CSLDestroy(runsList);
+
+    bool resume = m_checkpointFeatures > 0 &&
+            options.asBool(RESUME_OPTION, true) && !m_ovrReady &&
+            property(OVR_BUILD_OPTIONS_KEY, "", NG_ADDITIONS_KEY) == buildOptions;
+    for(const auto &path : checkpointRuns) {
+        if(!Folder::isExists(path)) {
+            resume = false;
+        }
+    }
+
+    clearOverviewRuns();
+    m_checkpointFid = -1;
+    m_checkpointRuns = 0;
+    if(resume) {
+        m_checkpointFid = CPLAtoGIntBig(property(OVR_CHECKPOINT_FID_KEY, "-1",
+                                                 NG_ADDITIONS_KEY).c_str());
+        m_ovrRuns = checkpointRuns;
+        m_checkpointRuns = m_ovrRuns.size();
+        CPLDebug("ngstore", "Resume overviews creation after feature " CPL_FRMT_GIB,
+                 m_checkpointFid);
+    }
+    else {
+        for(const auto &path : checkpointRuns) {
+            File::deleteFile(path);
+        }
+    }
+
+    // All tiles are saved at the end, runs hold tiles of resumed build
+    if(nullptr == m_ovrTable) {
+        m_ovrTable = parentDS->createOverviewsTable(name());
+        MutexHolder holder(m_tileStoreMutex);
+        m_tileStore.reset();
+    }
+    else {
+        parentDS->clearOverviewsTable(name());
+    }
+    parentDS->dropOverviewsTableIndex(name());
+
+    // Fill overview layer with data
+    fillZoomLevels(zoomLevelListStr);
+    if(m_zoomLevels.empty()) {
+        return true;
+    }
+
+    // Overviews are not used until finished
+    m_ovrReady = false;
+    setProperty(OVR_STATE_KEY, OVR_STATE_BUILDING, NG_ADDITIONS_KEY);
+    setProperty(OVR_BUILD_OPTIONS_KEY, buildOptions, NG_ADDITIONS_KEY);
+    if(!resume) {
+        setProperty(OVR_CHECKPOINT_RUNS_KEY, "", NG_ADDITIONS_KEY);
+        setProperty(OVR_CHECKPOINT_FID_KEY, "-1", NG_ADDITIONS_KEY);
+    }
+
+    setProperty("zoom_levels", zoomLevelListStr, NG_ADDITIONS_KEY);
+
+    m_compressTiles = compressTiles;
+    setProperty(COMPRESS_TILES_KEY, fromBool(m_compressTiles), NG_ADDITIONS_KEY);
+
+    m_simplifyType = GEOSGeometryWrap::simplifyTypeFromString(simplifyStr);
+    setProperty(SIMPLIFY_KEY, simplifyStr, NG_ADDITIONS_KEY);
+
+    // Tile and simplify geometry
+    progress.onProgress(COD_IN_PROCESS, 0.0,
+                        _("Start tiling and simplifying geometry"));
+
+    m_clusterPoints = clusterPointsBuild;
+    setProperty(CLUSTER_POINTS_KEY, fromBool(m_clusterPoints), NG_ADDITIONS_KEY);
+    m_clusterRadius = std::max(options.asDouble(CLUSTER_RADIUS_OPTION,
+                                                DEFAULT_CLUSTER_RADIUS), 1.0);
+    setProperty(CLUSTER_RADIUS_KEY, CPLSPrintf("%g", m_clusterRadius),
+                NG_ADDITIONS_KEY);
+
+    // Tiles are flushed to sorted runs on disk if memory budget exceeded.
+    // Pyramid build needs all tiles of zoom level in memory.
+    m_pyramidBuild = options.asBool(PYRAMID_OPTION, false) &&
+            m_zoomLevels.size() > 1 && !m_clusterPoints;
+    m_memoryBudget = m_pyramidBuild ? 0 :
+            static_cast<size_t>(options.asDouble(MEMORY_BUDGET_OPTION,
+                                                 DEFAULT_MEMORY_BUDGET) *
+                                1024 * 1024);
+    m_genTilesSize = 0;
 
     Progress newProgress(progress);
     newProgress.setTotalSteps(2);
     newProgress.setStep(0);
-    threadPool.waitComplete(newProgress);
-    threadPool.clearThreadData();
+    emptyFields(true);
+    reset();
+
+    if(m_clusterPoints) {
+        if(!clusterPoints(newProgress)) {
+            emptyFields(false);
+            reset();
+            return overviewsFailed(progress, COD_CANCELED,
+                                   _("Overviews creation interrupted"));
+        }
+    }
+    else {
+        int threadCount = options.asInt(NUM_THREADS_OPTION, getNumberThreads());
+        if(!tileFeatures(newProgress, static_cast<unsigned char>(
+                             std::min(std::max(threadCount, 1), 255)))) {
+            // Saved checkpoint is used to resume on next call
+            emptyFields(false);
+            reset();
+            m_genTiles.clear();
+            m_genTilesSize = 0;
+            releaseOverviewRuns();
+            progress.onProgress(COD_CANCELED, 0.0,
+                                _("Overviews creation interrupted"));
+            return false;
+        }
+    }
 
     emptyFields(false);
     reset();
 
+    // Flush the rest of tiles to merge them with previous runs
+    if(!m_ovrRuns.empty() && !flushOverviewRun()) {
+        return overviewsFailed(progress, COD_CREATE_FAILED,
+                               _("Failed to flush overview tiles"));
+    }
+
     // Save tiles
     m_creatingOvr = true;
     parentDS->lockExecuteSql(true);
     parentDS->startBatchOperation();
 
     CPLDebug("ngstore", "finish create overviews");
-    double counter = 0.0;
     newProgress.setStep(1);
-    for(auto item : m_genTiles) {
-        if(!item.second.isValid() || item.second.empty()) {
-            continue;
+    bool transaction = parentDS->m_addsDS &&
+            parentDS->m_addsDS->StartTransaction() == OGRERR_NONE;
+    bool result = true;
+    if(m_pyramidBuild) {
+        result = buildPyramid(newProgress);
+    }
+    else if(m_ovrRuns.empty()) {
+        double counter = 0.0;
+        for(auto &item : m_genTiles) {
+            if(!saveOverviewTile(ngsTileFromKey(item.first), item.second) ||
+               !newProgress.onProgress(COD_IN_PROCESS,
+                                       counter/m_genTiles.size(),
+                                       _("Save tiles ..."))) {
+                result = false;
+                break;
+            }
+            counter++;
         }
-        BufferPtr data = item.second.save();
-
-        FeaturePtr newFeature = OGRFeature::CreateFeature(
-                    m_ovrTable->GetLayerDefn() );
-
-        newFeature->SetField(OVR_ZOOM_KEY, item.first.z);
-        newFeature->SetField(OVR_X_KEY, item.first.x);
-        newFeature->SetField(OVR_Y_KEY, item.first.y);
-        newFeature->SetField(newFeature->GetFieldIndex(OVR_TILE_KEY), data->size(),
-                          data->data());
-
-//        CPLDebug("ngstore", "Tile size to store %d", data->size());
+    }
+    else {
+        result = mergeOverviewRuns(newProgress);
+    }
 
-        if(m_ovrTable->CreateFeature(newFeature) != OGRERR_NONE) {
-            outMessage(COD_INSERT_FAILED, _("Failed to create feature"));
+    if(transaction) {
+        if(result) {
+            result = parentDS->m_addsDS->CommitTransaction() == OGRERR_NONE;
+        }
+        else {
+            parentDS->m_addsDS->RollbackTransaction();
         }
-
-        newProgress.onProgress(COD_IN_PROCESS, counter/m_genTiles.size(),
-                               _("Save tiles ..."));
-        counter++;
     }
-
     parentDS->stopBatchOperation();
     m_genTiles.clear();
+    m_genTilesSize = 0;
+
+    if(!result) {
+        // Runs saved at checkpoint are kept to resume with saving
+        parentDS->lockExecuteSql(false);
+        return overviewsFailed(progress, COD_CREATE_FAILED,
+                               _("Failed to save overview tiles"));
+    }
+
+    clearOverviewRuns();
+    setProperty(OVR_CHECKPOINT_RUNS_KEY, "", NG_ADDITIONS_KEY);
+    setProperty(OVR_CHECKPOINT_FID_KEY, "-1", NG_ADDITIONS_KEY);
 
     // Create index
     parentDS->createOverviewsTableIndex(name());
+    buildPresenceFilters();
     parentDS->lockExecuteSql(false);
+    m_tileCache.clear();
     m_creatingOvr = false;
+    m_pyramidBuild = false;
+
+    setProperty(OVR_STATE_KEY, OVR_STATE_READY, NG_ADDITIONS_KEY);
+    m_ovrReady = true;
 
     progress.onProgress(COD_FINISHED, 1.0,
                         _("Finish tiling and simplifying geometry"));
@@ -331,39 +1279,24 @@ bool FeatureClassOverview::createOverviews(const Progress &progress, const Optio
     return true;
 }
 
-VectorTile FeatureClassOverview::getTile(const Tile &tile, const Envelope &tileExtent)
+VectorTilePtr FeatureClassOverview::getTile(const Tile &tile,
+                                            const Envelope &tileExtent)
 {
     VectorTile vtile;
     Dataset * const dataset = dynamic_cast<Dataset*>(m_parent);
     if(nullptr == dataset || m_creatingOvr) {
-        return vtile;
+        return std::make_shared<const VectorTile>();
     }
 
     if(!extent().intersects(tileExtent)) {
-        return vtile;
+        return std::make_shared<const VectorTile>();
     }
 
-    if(hasOverviews()) {
-        if(tile.z <= *m_zoomLevels.rbegin()) {
-//
-//            // Get closest zoom level
-//            unsigned char diff = 127;
-//            unsigned char z = 0;
-//            for(auto zoomLevel : m_zoomLevels) {
-//                unsigned char newDiff = static_cast<unsigned char>(
-//                            ABS(zoomLevel - tile.z));
-//                if(newDiff < diff) {
-//                    z = zoomLevel;
-//                    diff = newDiff;
-//                    if(diff == 0)
-//                        break;
-//                }
-//            }
-
-            vtile = getTileInternal(tile);
-//            if(vtile.isValid()) {
-                return vtile;
-//            }
+    if(hasOverviews() && !m_zoomLevels.empty() &&
+       tile.z <= *m_zoomLevels.rbegin()) {
+        VectorTilePtr nearest = getNearestTile(tile);
+        if(nearest) {
+            return nearest;
         }
     }
 
@@ -410,22 +1343,32 @@ VectorTile FeatureClassOverview::getTile(const Tile &tile, const Envelope &tileE
     dataset->lockExecuteSql(false);
     m_featureMutex.release();
 
-    while(!features.empty()) {
-        feature = features.back();
-
-        OGRGeometry* geom = feature->GetGeometryRef();
-        if(nullptr != geom) {
-
-            GEOSGeometryPtr geosGeom(new GEOSGeometryWrap(geom));
-            GIntBig fid = feature->GetFID();
-            geosGeom->simplify(step);
+    // Generalize, clip and fill features in parallel, only cursor read above
+    // is serialized.
+    std::vector<VectorTileItemArray> results(features.size());
+    if(features.size() < PARALLEL_TILING_MIN_FEATURES) {
+        for(size_t i = 0; i < features.size(); ++i) {
+            tileFeature(features[i], step, tile, tileExtent, results[i]);
+        }
+    }
+    else {
+        TileFeatureJobs jobs(features.size());
+        for(size_t i = 0; i < features.size(); ++i) {
+            m_tilingPool.addThreadData(new TileFeatureData(this, features[i],
+                                                           step, tile,
+                                                           tileExtent,
+                                                           &results[i],
+                                                           &jobs, true));
+        }
+        jobs.wait();
+    }
+    features.clear();
 
-            VectorTileItemArray items = tileGeometry(fid, geosGeom, tileExtent);
-            if(!items.empty()) {
-                vtile.add(items, false);
-            }
+    // Keep the same items order as in sequential tiling
+    for(auto it = results.rbegin(); it != results.rend(); ++it) {
+        if(!it->empty()) {
+            vtile.add(*it, false);
         }
-        features.pop_back();
     }
 
 //    Debug test
@@ -445,11 +1388,101 @@ VectorTile FeatureClassOverview::getTile(const Tile &tile, const Envelope &tileE
 //        }
 //    }
 
-    return vtile;
+    return std::make_shared<const VectorTile>(std::move(vtile));
+}
+
+void FeatureClassOverview::tileFeature(FeaturePtr feature, double step,
+                                       const Tile &tile, const Envelope &extent,
+                                       VectorTileItemArray &items) const
+{
+    OGRGeometry *geom = feature->GetGeometryRef();
+    if(nullptr == geom) {
+        return;
+    }
+
+    GEOSGeometryPtr geosGeom(new GEOSGeometryWrap(geom));
+    geosGeom->simplify(step, m_simplifyType);
+    items = tileGeometry(feature->GetFID(), geosGeom, tile, extent);
+}
+
+bool FeatureClassOverview::tileFeatureThreadFunc(ThreadData *threadData)
+{
+    TileFeatureData *data = static_cast<TileFeatureData*>(threadData);
+    data->m_featureClass->tileFeature(data->m_feature, data->m_step,
+                                      data->m_tile, data->m_extent,
+                                      *data->m_items);
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::cacheTiles Reads stored overview tiles with one
+ * query per zoom level and puts them to the tiles cache.
+ * @param tiles Tiles to read, i.e. all new tiles of the map viewport.
+ */
+void FeatureClassOverview::cacheTiles(const std::vector<TileItem> &tiles)
+{
+    if(m_creatingOvr || m_zoomLevels.empty() || !hasOverviews()) {
+        return;
+    }
+
+    // Taken before the pending tiles check, see getTileInternal
+    GUIntBig generation = m_tileCache.generation();
+    std::map<unsigned char, std::set<Tile>> zoomTiles;
+    for(const auto &item : tiles) {
+        if(item.tile.z > *m_zoomLevels.rbegin() ||
+           m_tileCache.contains(item.tile) || dirtyTileExists(item.tile)) {
+            continue;
+        }
+        zoomTiles[item.tile.z].insert(cacheKey(item.tile));
+    }
+
+    DatasetExecuteSQLLockHolder holder(dynamic_cast<Dataset*>(m_parent));
+    OverviewTileStore *store = tileStore();
+    if(nullptr == store) {
+        return;
+    }
+
+    for(auto &zoomTile : zoomTiles) {
+        std::set<Tile> &requested = zoomTile.second;
+        int minX = requested.begin()->x;
+        int maxX = requested.rbegin()->x;
+        int minY = requested.begin()->y;
+        int maxY = minY;
+        for(const auto &tile : requested) {
+            minY = MIN(minY, tile.y);
+            maxY = MAX(maxY, tile.y);
+        }
+
+        std::vector<OverviewTileStore::TileData> data;
+        if(!store->readTiles(zoomTile.first, minX, minY, maxX, maxY, data)) {
+            continue;
+        }
+
+        for(auto &item : data) {
+            auto it = requested.find(item.first);
+            if(it == requested.end()) {
+                continue;
+            }
+            requested.erase(it);
+
+            std::shared_ptr<VectorTile> vtile(new VectorTile);
+            Buffer buff(item.second.data(), static_cast<int>(item.second.size()),
+                        false);
+            vtile->load(buff, ngsTileOrigin(item.first));
+            m_tileCache.put(item.first, vtile, generation);
+        }
+
+        // Missing tiles are cached too.
+        for(const auto &tile : requested) {
+            m_tileCache.put(tile, std::make_shared<const VectorTile>(),
+                            generation);
+        }
+    }
 }
 
 VectorTileItemArray FeatureClassOverview::tileGeometry(GIntBig fid,
                                                        GEOSGeometryPtr geom,
+                                                       const Tile &tile,
                                                        const Envelope &env) const
 {
     VectorTileItemArray out;
@@ -457,8 +1490,7 @@ VectorTileItemArray FeatureClassOverview::tileGeometry(GIntBig fid,
         return out;
     }
 
-    GEOSGeometryPtr clipGeom = geom->clip(env);
-    clipGeom->fillTile(fid, out);
+    geom->fillClippedTile(fid, env, out, ngsTileOrigin(tile));
 
     return out;
 }
@@ -479,6 +1511,16 @@ bool FeatureClassOverview::destroy()
         return false;
     }
 
+    {
+        MutexHolder holder(m_dirtyTilesMutex);
+        m_dirtyTiles.clear();
+    }
+    m_tileCache.clear();
+    {
+        MutexHolder holder(m_tileStoreMutex);
+        m_tileStore.reset();
+    }
+
     dataset->destroyOverviewsTable(name); // Overviews table maybe not exists
 
     return true;
@@ -505,13 +1547,18 @@ void FeatureClassOverview::fillZoomLevels(const std::string &zoomLevels)
     }
 }
 
-Envelope FeatureClassOverview::extraExtentForZoom(unsigned char zoom, const Envelope &env)
+double FeatureClassOverview::extraSizeForZoom(unsigned char zoom)
 {
-    Envelope extent = env;
     int tilesInMapOneDim = 1 << zoom;
     double halfTilesInMapOneDim = tilesInMapOneDim * 0.5;
     double tilesSizeOneDim = DEFAULT_BOUNDS.maxX() / halfTilesInMapOneDim;
-    double extraSize = tilesSizeOneDim * TILE_RESIZE - tilesSizeOneDim;
+    return tilesSizeOneDim * TILE_RESIZE - tilesSizeOneDim;
+}
+
+Envelope FeatureClassOverview::extraExtentForZoom(unsigned char zoom, const Envelope &env)
+{
+    Envelope extent = env;
+    double extraSize = extraSizeForZoom(zoom);
     extent.setMinX(extent.minX() - extraSize);
     extent.setMinY(extent.minY() - extraSize);
     extent.setMaxX(extent.maxX() + extraSize);
@@ -531,69 +1578,49 @@ void FeatureClassOverview::onFeatureInserted(FeaturePtr feature)
     if(nullptr == geom) {
         return;
     }
+
+    if(m_clusterPoints) {
+        updatePointClusters(feature->GetFID(), nullptr, geom);
+        if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+            flushDirtyTiles();
+        }
+        return;
+    }
+
     bool precisePixelSize = !(OGR_GT_Flatten(geom->getGeometryType()) == wkbPoint ||
                               OGR_GT_Flatten(geom->getGeometryType()) == wkbMultiPoint);
 
     GEOSGeometryPtr geosGeom(new GEOSGeometryWrap(geom));
     GIntBig fid = feature->GetFID();
 
-    OGREnvelope env;
-    geom->getEnvelope(&env);
-    Envelope extentBase = env;
-    extentBase.fix();
-
     auto zoomLevelsList = zoomLevels();
     for(auto it = zoomLevelsList.rbegin(); it != zoomLevelsList.rend(); ++it) {
         unsigned char zoomLevel = *it;
-        Envelope extent = extraExtentForZoom(zoomLevel, extentBase);
-        std::vector<TileItem> items =
-                MapTransform::getTilesForExtent(extent, zoomLevel, false, true);
+        std::vector<TileItem> items = MapTransform::getTilesForGeometry(
+                    *geom, zoomLevel, extraSizeForZoom(zoomLevel), true);
 
         double step = FeatureClassOverview::pixelSize(zoomLevel, precisePixelSize);
-        geosGeom->simplify(step);
+        geosGeom->simplify(step, m_simplifyType);
 
         for(auto tileItem : items) {
 
             Envelope ext = tileItem.env;
             ext.resize(TILE_RESIZE);
 
-            auto vItem = tileGeometry(fid, geosGeom, ext);
-
-            FeaturePtr tile = getTileFeature(tileItem.tile);
-            VectorTile  vtile;
-            bool create = true;
-            if(tile) {
-                int size = 0;
-                GByte *data = tile->GetFieldAsBinary(
-                            tile->GetFieldIndex(OVR_TILE_KEY), &size);
-                Buffer buff(data, size, false);
-                vtile.load(buff);
-                create = false;
+            auto vItem = tileGeometry(fid, geosGeom, tileItem.tile, ext);
+            if(vItem.empty()) {
+                continue;
             }
-            else {
-                tile = OGRFeature::CreateFeature(m_ovrTable->GetLayerDefn());
 
-                tile->SetField(OVR_ZOOM_KEY, tileItem.tile.z);
-                tile->SetField(OVR_X_KEY, tileItem.tile.x);
-                tile->SetField(OVR_Y_KEY, tileItem.tile.y);
-            }
+            VectorTile vtile = *getTileInternal(tileItem.tile);
             vtile.add(vItem, true);
-
-            // Add tile back
-            if(vtile.isValid()) {
-                BufferPtr data = vtile.save();
-                tile->SetField(tile->GetFieldIndex(OVR_TILE_KEY), data->size(),
-                               data->data());
-
-                if(create) {
-                    createTileFeature(tile);
-                }
-                else {
-                    setTileFeature(tile);
-                }
-            }
+            setDirtyTile(tileItem.tile, vtile);
         }
     }
+
+    if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+        flushDirtyTiles();
+    }
 }
 
 void FeatureClassOverview::onFeatureUpdated(FeaturePtr oldFeature,
@@ -605,27 +1632,22 @@ void FeatureClassOverview::onFeatureUpdated(FeaturePtr oldFeature,
         return;
     }
 
+    if(m_clusterPoints) {
+        updatePointClusters(newFeature->GetFID(),
+                            oldFeature->GetGeometryRef(),
+                            newFeature->GetGeometryRef());
+        if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+            flushDirtyTiles();
+        }
+        return;
+    }
+
     bool precisePixelSize = !(OGR_GT_Flatten(geometryType()) == wkbPoint ||
                               OGR_GT_Flatten(geometryType()) == wkbMultiPoint);
 
 
     OGRGeometry *originalGeom = oldFeature->GetGeometryRef();
     OGRGeometry *newGeom = newFeature->GetGeometryRef();
-    Envelope extentBase;
-
-    if(nullptr != originalGeom) {
-        OGREnvelope env;
-        originalGeom->getEnvelope(&env);
-        extentBase = env;
-    }
-
-    if(nullptr != newGeom) {
-        OGREnvelope env;
-        newGeom->getEnvelope(&env);
-        extentBase.merge(env);
-    }
-
-    extentBase.fix();
 
     GEOSGeometryPtr geosGeom(new GEOSGeometryWrap(newGeom));
     GIntBig fid = newFeature->GetFID();
@@ -633,56 +1655,55 @@ void FeatureClassOverview::onFeatureUpdated(FeaturePtr oldFeature,
     auto zoomLevelsList = zoomLevels();
     for(auto it = zoomLevelsList.rbegin(); it != zoomLevelsList.rend(); ++it) {
         unsigned char zoomLevel = *it;
-        Envelope extent = extraExtentForZoom(zoomLevel, extentBase);
-
-        std::vector<TileItem> items =
-                MapTransform::getTilesForExtent(extent, zoomLevel, false, true);
+        std::vector<TileItem> items = tilesForUpdate(originalGeom, newGeom,
+                                                     zoomLevel);
 
         double step = FeatureClassOverview::pixelSize(zoomLevel, precisePixelSize);
-        geosGeom->simplify(step);
+        geosGeom->simplify(step, m_simplifyType);
 
         for(auto tileItem : items) {
-            FeaturePtr tile = getTileFeature(tileItem.tile);
-            VectorTile  vtile;
-            bool create = true;
-            if(tile) {
-                int size = 0;
-                GByte *data = tile->GetFieldAsBinary(
-                            tile->GetFieldIndex(OVR_TILE_KEY), &size);
-                Buffer buff(data, size, false);
-                vtile.load(buff);
-                create = false;
-            }
-            else {
-                tile = OGRFeature::CreateFeature(m_ovrTable->GetLayerDefn());
-
-                tile->SetField(OVR_ZOOM_KEY, tileItem.tile.z);
-                tile->SetField(OVR_X_KEY, tileItem.tile.x);
-                tile->SetField(OVR_Y_KEY, tileItem.tile.y);
-            }
-
+            VectorTile vtile = *getTileInternal(tileItem.tile);
             vtile.remove(oldFeature->GetFID());
 
             Envelope env = tileItem.env;
             env.resize(TILE_RESIZE);
-            auto vItem = tileGeometry(fid, geosGeom, env);
+            auto vItem = tileGeometry(fid, geosGeom, tileItem.tile, env);
             vtile.add(vItem, true);
+            setDirtyTile(tileItem.tile, vtile);
+        }
+    }
 
-            // Add tile back
-            if(vtile.isValid()) {
-                BufferPtr data = vtile.save();
-                tile->SetField(tile->GetFieldIndex(OVR_TILE_KEY), data->size(),
-                                                     data->data());
+    if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+        flushDirtyTiles();
+    }
+}
 
-                if(create) {
-                    createTileFeature(tile);
-                }
-                else {
-                    setTileFeature(tile);
-                }
+/**
+ * @brief FeatureClassOverview::tilesForUpdate Returns tiles covered by old or
+ * new feature geometry.
+ * @param oldGeom Geometry before update. May be null.
+ * @param newGeom Geometry after update. May be null.
+ * @param zoom Zoom level.
+ * @return Tiles array without duplicates.
+ */
+std::vector<TileItem> FeatureClassOverview::tilesForUpdate(
+        const OGRGeometry *oldGeom, const OGRGeometry *newGeom,
+        unsigned char zoom)
+{
+    std::vector<TileItem> out;
+    std::set<Tile> added;
+    for(const OGRGeometry *geom : {oldGeom, newGeom}) {
+        if(nullptr == geom) {
+            continue;
+        }
+        for(const auto &tileItem : MapTransform::getTilesForGeometry(
+                *geom, zoom, extraSizeForZoom(zoom), true)) {
+            if(added.insert(tileItem.tile).second) {
+                out.push_back(tileItem);
             }
         }
     }
+    return out;
 }
 
 void FeatureClassOverview::onFeatureDeleted(FeaturePtr delFeature)
@@ -693,40 +1714,34 @@ void FeatureClassOverview::onFeatureDeleted(FeaturePtr delFeature)
         return;
     }
 
-    OGREnvelope env;OGRGeometry *geom = delFeature->GetGeometryRef();
-    geom->getEnvelope(&env);
+    OGRGeometry *geom = delFeature->GetGeometryRef();
+    if(nullptr == geom) {
+        return;
+    }
+
+    if(m_clusterPoints) {
+        updatePointClusters(delFeature->GetFID(), geom, nullptr);
+        if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+            flushDirtyTiles();
+        }
+        return;
+    }
 
     for(auto zoomLevel : zoomLevels()) {
-        Envelope extent = extraExtentForZoom(zoomLevel, env);
-        std::vector<TileItem> items =
-                MapTransform::getTilesForExtent(extent, zoomLevel, false, true);
+        std::vector<TileItem> items = MapTransform::getTilesForGeometry(
+                    *geom, zoomLevel, extraSizeForZoom(zoomLevel), true);
         for(auto tileItem : items) {
-            FeaturePtr tile = getTileFeature(tileItem.tile);
-
-            VectorTile  vtile;
-            if(tile) {
-                int size = 0;
-                GByte *data = tile->GetFieldAsBinary(
-                            tile->GetFieldIndex(OVR_TILE_KEY), &size);
-                Buffer buff(data, size, false);
-                if(vtile.load(buff)) {
-                    vtile.remove(delFeature->GetFID());
-                }
-            }
-
-            // Add tile back
+            VectorTile vtile = *getTileInternal(tileItem.tile);
             if(vtile.isValid()) {
-                BufferPtr data = vtile.save();
-                tile->SetField(tile->GetFieldIndex(OVR_TILE_KEY), data->size(),
-                               data->data());
-
-                setTileFeature(tile);
-            }
-            else if(tile) {
-                ngsUnused(m_ovrTable->DeleteFeature(tile->GetFID()));
+                vtile.remove(delFeature->GetFID());
+                setDirtyTile(tileItem.tile, vtile);
             }
         }
     }
+
+    if(dirtyTilesCount() >= m_dirtyTilesLimit) {
+        flushDirtyTiles();
+    }
 }
 
 void FeatureClassOverview::onFeaturesDeleted()
@@ -735,12 +1750,1112 @@ void FeatureClassOverview::onFeaturesDeleted()
     if(nullptr != dataset) {
         dataset->clearOverviewsTable(name());
     }
+    clearPresenceFilters();
+    for(unsigned char zoomLevel : m_zoomLevels) {
+        storePresenceFilter(zoomLevel, TilePresenceFilter());
+    }
+
+    MutexHolder holder(m_dirtyTilesMutex);
+    m_dirtyTiles.clear();
+    m_tileCache.clear();
 }
 
-void FeatureClassOverview::addOverviewItem(const Tile &tile, const VectorTileItemArray &items)
+bool FeatureClassOverview::getDirtyTile(const Tile &tile, VectorTile &vtile) const
 {
-    MutexHolder holder(m_genTileMutex, 150.0);
-    m_genTiles[tile].add(items, true);
+    MutexHolder holder(m_dirtyTilesMutex);
+    auto it = m_dirtyTiles.find(cacheKey(tile));
+    if(it == m_dirtyTiles.end()) {
+        it = m_flushTiles.find(cacheKey(tile));
+        if(it == m_flushTiles.end()) {
+            return false;
+        }
+    }
+    vtile = it->second;
+    return true;
+}
+
+void FeatureClassOverview::setDirtyTile(const Tile &tile, const VectorTile &vtile)
+{
+    {
+        MutexHolder holder(m_dirtyTilesMutex);
+        m_dirtyTiles[cacheKey(tile)] = vtile;
+    }
+    m_tileCache.remove(tile);
+    removeNearestTiles(tile);
+}
+
+bool FeatureClassOverview::dirtyTileExists(const Tile &tile) const
+{
+    MutexHolder holder(m_dirtyTilesMutex);
+    Tile key = cacheKey(tile);
+    return m_dirtyTiles.find(key) != m_dirtyTiles.end() ||
+            m_flushTiles.find(key) != m_flushTiles.end();
+}
+
+size_t FeatureClassOverview::dirtyTilesCount() const
+{
+    MutexHolder holder(m_dirtyTilesMutex);
+    return m_dirtyTiles.size();
+}
+
+bool FeatureClassOverview::writeTile(const Tile &tile, const VectorTile &vtile)
+{
+    if(!vtile.isValid() || vtile.empty()) {
+        OverviewTileStore *store = tileStore();
+        if(nullptr != store) {
+            return store->deleteTile(tile);
+        }
+
+        FeaturePtr feature = getTileFeature(tile);
+        if(feature) {
+            return m_ovrTable->DeleteFeature(feature->GetFID()) == OGRERR_NONE;
+        }
+        return true;
+    }
+
+    BufferPtr data = saveTile(tile, vtile);
+    if(!writeTileData(tile, data->data(), static_cast<size_t>(data->size()))) {
+        return false;
+    }
+
+    // Removed tiles are kept in filter, it only gives false positive for them
+    MutexHolder holder(m_presenceMutex);
+    auto it = m_presenceFilters.find(tile.z);
+    if(it != m_presenceFilters.end()) {
+        it->second.add(tile.x, tile.y);
+        m_presenceChanged = true;
+    }
+    return true;
+}
+
+bool FeatureClassOverview::writeTileData(const Tile &tile, const GByte *data,
+                                         size_t size)
+{
+    OverviewTileStore *store = tileStore();
+    if(nullptr != store) {
+        return store->writeTile(tile, data, size);
+    }
+
+    FeaturePtr feature = getTileFeature(tile);
+    bool create = !feature;
+    if(create) {
+        feature = OGRFeature::CreateFeature(m_ovrTable->GetLayerDefn());
+        feature->SetField(OVR_ZOOM_KEY, tile.z);
+        feature->SetField(OVR_X_KEY, tile.x);
+        feature->SetField(OVR_Y_KEY, tile.y);
+    }
+
+    feature->SetField(feature->GetFieldIndex(OVR_TILE_KEY),
+                      static_cast<int>(size), data);
+    if(create) {
+        return createTileFeature(feature);
+    }
+    return setTileFeature(feature);
+}
+
+bool FeatureClassOverview::readTileData(const Tile &tile,
+                                        std::vector<GByte> &data)
+{
+    {
+        DatasetExecuteSQLLockHolder holder(dynamic_cast<Dataset*>(m_parent));
+        OverviewTileStore *store = tileStore();
+        if(nullptr != store) {
+            return store->readTile(tile, data);
+        }
+    }
+
+    data.clear();
+    FeaturePtr ovrTile = getTileFeature(tile);
+    if(ovrTile) {
+        int size = 0;
+        GByte *tileData = ovrTile->GetFieldAsBinary(
+                    ovrTile->GetFieldIndex(OVR_TILE_KEY), &size);
+        data.assign(tileData, tileData + size);
+    }
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::tileMayExist Checks tile in presence filter of
+ * its zoom level. Filters are loaded on first call.
+ * @param tile Tile to check.
+ * @return False if tile is surely not stored in overviews table.
+ */
+bool FeatureClassOverview::tileMayExist(const Tile &tile)
+{
+    bool loaded;
+    {
+        MutexHolder holder(m_presenceMutex);
+        loaded = m_presenceLoaded;
+    }
+
+    // Read without presence lock, as writers hold SQL lock first
+    if(!loaded) {
+        std::map<unsigned char, TilePresenceFilter> filters;
+        for(unsigned char zoomLevel : m_zoomLevels) {
+            TilePresenceFilter filter;
+            if(loadPresenceFilter(zoomLevel, filter)) {
+                filters[zoomLevel] = filter;
+            }
+        }
+
+        MutexHolder holder(m_presenceMutex);
+        if(!m_presenceLoaded) {
+            m_presenceFilters.swap(filters);
+            m_presenceLoaded = true;
+        }
+    }
+
+    MutexHolder holder(m_presenceMutex);
+    auto it = m_presenceFilters.find(tile.z);
+    if(it == m_presenceFilters.end()) {
+        return true;
+    }
+    return it->second.mayContain(tile.x, tile.y);
+}
+
+/**
+ * @brief FeatureClassOverview::loadPresenceFilter Reads presence filter of zoom
+ * level from layer properties.
+ * @param zoom Zoom level.
+ * @param filter Filter to load.
+ * @return True if filter is stored and valid.
+ */
+bool FeatureClassOverview::loadPresenceFilter(unsigned char zoom,
+                                              TilePresenceFilter &filter) const
+{
+    std::string value = property(OVR_PRESENCE_FILTER_KEY + std::to_string(zoom),
+                                 "", NG_ADDITIONS_KEY);
+    if(value.empty()) {
+        return false;
+    }
+
+    GByte *data = reinterpret_cast<GByte*>(CPLStrdup(value.c_str()));
+    int size = CPLBase64DecodeInPlace(data);
+    Buffer buff(data, size, false);
+    bool result = filter.load(buff);
+    CPLFree(data);
+    return result;
+}
+
+/**
+ * @brief FeatureClassOverview::storePresenceFilter Writes presence filter of
+ * zoom level base64 encoded to layer properties. Invalid filter clears stored
+ * one.
+ * @param zoom Zoom level.
+ * @param filter Filter to store.
+ * @return True on success.
+ */
+bool FeatureClassOverview::storePresenceFilter(unsigned char zoom,
+                                               const TilePresenceFilter &filter)
+{
+    Dataset *parentDS = dynamic_cast<Dataset*>(m_parent);
+    if(nullptr == parentDS) {
+        return false;
+    }
+
+    std::string value;
+    if(filter.isValid()) {
+        BufferPtr data = filter.save();
+        char *encoded = CPLBase64Encode(data->size(), data->data());
+        value = encoded;
+        CPLFree(encoded);
+    }
+
+    // Filters are big, so they are not copied to the layer metadata
+    return parentDS->setProperty(OVR_PRESENCE_FILTER_KEY + std::to_string(zoom),
+                                 value, fullPropertyDomain(NG_ADDITIONS_KEY));
+}
+
+/**
+ * @brief FeatureClassOverview::buildPresenceFilters Scans tile keys of the
+ * overviews table and stores presence filter of each zoom level in layer
+ * properties. Caller must hold the dataset SQL lock.
+ * @return True on success.
+ */
+bool FeatureClassOverview::buildPresenceFilters()
+{
+    if(!hasTilesTable()) {
+        return false;
+    }
+
+    std::map<unsigned char, std::vector<std::pair<int, int>>> keys;
+    const char *ignoredFields[] = { OVR_TILE_KEY, nullptr };
+    m_ovrTable->SetIgnoredFields(ignoredFields);
+    m_ovrTable->ResetReading();
+    OGRFeature *feature;
+    while((feature = m_ovrTable->GetNextFeature()) != nullptr) {
+        int z = feature->GetFieldAsInteger(OVR_ZOOM_KEY);
+        keys[static_cast<unsigned char>(z)].push_back(
+                std::make_pair(feature->GetFieldAsInteger(OVR_X_KEY),
+                               feature->GetFieldAsInteger(OVR_Y_KEY)));
+        OGRFeature::DestroyFeature(feature);
+    }
+    m_ovrTable->SetIgnoredFields(nullptr);
+
+    MutexHolder holder(m_presenceMutex);
+    m_presenceFilters.clear();
+    bool result = true;
+    for(unsigned char zoomLevel : m_zoomLevels) {
+        const auto &zoomKeys = keys[zoomLevel];
+        TilePresenceFilter filter(zoomKeys.size());
+        for(const auto &key : zoomKeys) {
+            filter.add(key.first, key.second);
+        }
+        m_presenceFilters[zoomLevel] = filter;
+        if(!storePresenceFilter(zoomLevel, filter)) {
+            result = false;
+        }
+    }
+    m_presenceLoaded = true;
+    m_presenceChanged = false;
+    return result;
+}
+
+/**
+ * @brief FeatureClassOverview::savePresenceFilters Stores presence filters
+ * changed by tiles edits. Caller must hold the dataset SQL lock.
+ * @return True on success.
+ */
+bool FeatureClassOverview::savePresenceFilters()
+{
+    MutexHolder holder(m_presenceMutex);
+    if(!m_presenceChanged) {
+        return true;
+    }
+
+    bool result = true;
+    for(const auto &filter : m_presenceFilters) {
+        if(!storePresenceFilter(filter.first, filter.second)) {
+            result = false;
+        }
+    }
+    m_presenceChanged = !result;
+    return result;
+}
+
+void FeatureClassOverview::clearPresenceFilters()
+{
+    MutexHolder holder(m_presenceMutex);
+    m_presenceFilters.clear();
+    m_presenceLoaded = false;
+    m_presenceChanged = false;
+}
+
+/**
+ * @brief FeatureClassOverview::flushDirtyTiles Writes tiles changed by feature
+ * edits to the overviews table in one transaction. Until flushed, readers get
+ * such tiles from the pending set.
+ * @return True on success.
+ */
+bool FeatureClassOverview::flushDirtyTiles()
+{
+    DataStore * const parentDS = dynamic_cast<DataStore*>(m_parent);
+
+    // Edits set pending tiles holding the SQL lock, so it is taken before the
+    // pending tiles mutex. It also keeps edits out till the flush ends.
+    DatasetExecuteSQLLockHolder lock(parentDS);
+    {
+        MutexHolder holder(m_dirtyTilesMutex);
+        if(m_dirtyTiles.empty()) {
+            return true;
+        }
+
+        if(nullptr == parentDS || !parentDS->m_addsDS || !hasTilesTable()) {
+            m_dirtyTiles.clear();
+            return false;
+        }
+
+        // Readers get the tiles from the flushed set till they are written,
+        // so they never see old ones and are not blocked by the writes.
+        m_flushTiles.swap(m_dirtyTiles);
+    }
+
+    CPLDebug("ngstore", "Flush %ld dirty tiles in %s",
+             static_cast<long>(m_flushTiles.size()), m_name.c_str());
+
+    bool transaction = parentDS->m_addsDS->StartTransaction() == OGRERR_NONE;
+    bool result = true;
+    for(const auto &item : m_flushTiles) {
+        if(!writeTile(item.first, item.second)) {
+            result = false;
+            break;
+        }
+    }
+    if(result) {
+        result = savePresenceFilters();
+    }
+
+    if(transaction) {
+        if(result) {
+            result = parentDS->m_addsDS->CommitTransaction() == OGRERR_NONE;
+        }
+        else {
+            parentDS->m_addsDS->RollbackTransaction();
+        }
+    }
+
+    MutexHolder holder(m_dirtyTilesMutex);
+    if(!result) {
+        // Keep tiles pending to try again on next flush.
+        m_dirtyTiles.insert(m_flushTiles.begin(), m_flushTiles.end());
+        m_flushTiles.clear();
+        return errorMessage(_("Failed to write overview tiles. %s"),
+                            CPLGetLastErrorMsg());
+    }
+
+    for(const auto &item : m_flushTiles) {
+        m_tileCache.remove(item.first);
+    }
+    m_flushTiles.clear();
+    return true;
+}
+
+bool FeatureClassOverview::sync()
+{
+    bool result = flushDirtyTiles();
+    return FeatureClass::sync() && result;
+}
+
+void FeatureClassOverview::addOverviewItem(const Tile &tile, const VectorTileItemArray &items)
+{
+    MutexHolder holder(m_genTileMutex, 150.0);
+    addGenTileItems(tile, items);
+}
+
+void FeatureClassOverview::addGenTileItems(const Tile &tile,
+                                           const VectorTileItemArray &items)
+{
+    TileKey key = ngsTileKey(tile);
+    auto it = m_genTiles.find(key);
+    if(it == m_genTiles.end()) {
+        it = m_genTiles.insert(std::make_pair(key, VectorTile())).first;
+        m_genTilesSize += sizeof(TileKey) + sizeof(VectorTile) + 4 * sizeof(void*);
+    }
+    // Items merged into existing ones add their ids only
+    m_genTilesSize += it->second.add(items, true);
+
+    if(m_memoryBudget > 0 && m_genTilesSize > m_memoryBudget) {
+        flushOverviewRun();
+    }
+}
+
+BufferPtr FeatureClassOverview::saveTile(const Tile &tile,
+                                         const VectorTile &vtile) const
+{
+    return vtile.save(pixelSize(tile.z, true) * TILE_QUANTIZE_FACTOR,
+                      m_compressTiles);
+}
+
+bool FeatureClassOverview::saveOverviewTile(const Tile &tile, VectorTile &vtile)
+{
+    if(!vtile.isValid() || vtile.empty()) {
+        return true;
+    }
+    BufferPtr data = saveTile(tile, vtile);
+
+    OverviewTileStore *store = tileStore();
+    if(nullptr != store) {
+        if(!store->insertTile(tile, data->data(),
+                              static_cast<size_t>(data->size()))) {
+            return outMessage(COD_INSERT_FAILED, _("Failed to insert tile"));
+        }
+        return true;
+    }
+
+    FeaturePtr newFeature = OGRFeature::CreateFeature(m_ovrTable->GetLayerDefn());
+
+    newFeature->SetField(OVR_ZOOM_KEY, tile.z);
+    newFeature->SetField(OVR_X_KEY, tile.x);
+    newFeature->SetField(OVR_Y_KEY, tile.y);
+    newFeature->SetField(newFeature->GetFieldIndex(OVR_TILE_KEY), data->size(),
+                         data->data());
+
+    if(m_ovrTable->CreateFeature(newFeature) != OGRERR_NONE) {
+        return outMessage(COD_INSERT_FAILED, _("Failed to create feature"));
+    }
+    return true;
+}
+
+bool FeatureClassOverview::flushOverviewRun()
+{
+    if(m_genTiles.empty()) {
+        return true;
+    }
+
+    Settings &settings = Settings::instance();
+    std::string tmpDir = settings.getString("common/cache_path", "");
+    std::string path;
+    if(tmpDir.empty()) {
+        path = CPLGenerateTempFilename("ngs_ovr");
+    }
+    else {
+        path = File::formFileName(tmpDir, "ngs_ovr_" + random(10));
+    }
+
+    VSILFILE *fp = VSIFOpenL(path.c_str(), "wb");
+    if(nullptr == fp) {
+        // Keep tiles in memory till the end.
+        m_memoryBudget = 0;
+        return errorMessage(_("Failed to create temporary file %s"),
+                            path.c_str());
+    }
+    m_ovrRuns.push_back(path);
+
+    // Keys are sorted in tile order, so the run is sorted too.
+    std::vector<TileKey> keys;
+    keys.reserve(m_genTiles.size());
+    for(const auto &item : m_genTiles) {
+        keys.push_back(item.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    bool result = true;
+    for(TileKey key : keys) {
+        const VectorTile &vtile = m_genTiles[key];
+        if(!vtile.isValid() || vtile.empty()) {
+            continue;
+        }
+        BufferPtr data = vtile.save();
+
+        Tile tile = ngsTileFromKey(key);
+        Buffer header;
+        header.put(static_cast<GUInt32>(tile.x));
+        header.put(static_cast<GUInt32>(tile.y));
+        header.put(static_cast<GByte>(tile.z));
+        header.put(static_cast<GByte>(tile.crossExtent));
+        header.put(static_cast<GUInt32>(data->size()));
+
+        if(VSIFWriteL(header.data(), RUN_RECORD_HEADER_SIZE, 1, fp) != 1 ||
+           VSIFWriteL(data->data(), static_cast<size_t>(data->size()), 1, fp) != 1) {
+            result = errorMessage(_("Failed to write temporary file %s"),
+                                  path.c_str());
+            break;
+        }
+    }
+    VSIFCloseL(fp);
+
+    if(!result) {
+        // Truncated run is dropped, keep tiles in memory till the end.
+        File::deleteFile(path);
+        m_ovrRuns.pop_back();
+        m_memoryBudget = 0;
+        return false;
+    }
+
+    CPLDebug("ngstore", "Flush %ld tiles (%ld bytes) to %s",
+             static_cast<long>(m_genTiles.size()),
+             static_cast<long>(m_genTilesSize), path.c_str());
+
+    m_genTiles.clear();
+    m_genTilesSize = 0;
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::overviewsFailed Frees generated tiles and marks
+ * overviews as failed, so they are not used till rebuilt.
+ * @param progress Progress to report.
+ * @param code Code to report.
+ * @param message Message to report.
+ * @return Always false.
+ */
+bool FeatureClassOverview::overviewsFailed(const Progress &progress,
+                                           enum ngsCode code,
+                                           const std::string &message)
+{
+    m_genTiles.clear();
+    m_genTilesSize = 0;
+    releaseOverviewRuns();
+    m_tileCache.clear();
+    m_creatingOvr = false;
+    m_pyramidBuild = false;
+    m_ovrReady = false;
+    setProperty(OVR_STATE_KEY, OVR_STATE_FAILED, NG_ADDITIONS_KEY);
+    progress.onProgress(code, 0.0, message.c_str());
+    return errorMessage(message.c_str());
+}
+
+bool FeatureClassOverview::mergeOverviewRuns(const Progress &progress)
+{
+    GIntBig totalSize = 0;
+    std::vector<OverviewRunReaderPtr> runs;
+    for(const auto &path : m_ovrRuns) {
+        totalSize += File::fileSize(path);
+        OverviewRunReaderPtr run(new OverviewRunReader(path));
+        if(run->next()) {
+            runs.push_back(std::move(run));
+        }
+    }
+
+    // K-way merge of sorted runs. Each run holds the tile key only once.
+    bool result = true;
+    GIntBig readSize = 0;
+    while(!runs.empty()) {
+        Tile minTile = runs.front()->tile();
+        for(const auto &run : runs) {
+            if(run->tile() < minTile) {
+                minTile = run->tile();
+            }
+        }
+
+        VectorTile vtile;
+        auto it = runs.begin();
+        while(it != runs.end()) {
+            if((*it)->tile() == minTile) {
+                VectorTile runTile = (*it)->vectorTile();
+                vtile.add(runTile.items(), true);
+                readSize += (*it)->recordSize();
+                if(!(*it)->next()) {
+                    it = runs.erase(it);
+                    continue;
+                }
+            }
+            ++it;
+        }
+
+        if(!saveOverviewTile(minTile, vtile)) {
+            result = false;
+            break;
+        }
+
+        if(totalSize > 0 &&
+           !progress.onProgress(COD_IN_PROCESS,
+                                MIN(1.0, static_cast<double>(readSize) / totalSize),
+                                _("Save tiles ..."))) {
+            result = false;
+            break;
+        }
+    }
+
+    return result;
+}
+
+Envelope FeatureClassOverview::tileEnvelope(const Tile &tile)
+{
+    double tileSize = DEFAULT_BOUNDS.width() / (1 << tile.z);
+    double minX = DEFAULT_BOUNDS.minX() + tile.x * tileSize;
+    double minY = DEFAULT_BOUNDS.minY() + tile.y * tileSize;
+    return Envelope(minX, minY, minX + tileSize, minY + tileSize);
+}
+
+bool FeatureClassOverview::pyramidTileThreadFunc(ThreadData *threadData)
+{
+    PyramidTileData *data = static_cast<PyramidTileData*>(threadData);
+    data->m_featureClass->buildPyramidTile(data->m_tile, data->m_children,
+                                           *data->m_vtile);
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::buildPyramidTile Builds tile from the tiles of
+ * more detailed zoom level. Feature pieces are restored from child tiles,
+ * dissolved and generalized for the tile zoom.
+ * @param tile Tile to build.
+ * @param children Child tiles.
+ * @param vtile Output tile.
+ */
+void FeatureClassOverview::buildPyramidTile(const Tile &tile,
+        const std::vector<VectorTileRef> &children, VectorTile &vtile) const
+{
+    std::map<FeatureIdSet, std::vector<VectorTileItemRef>> features;
+    for(const auto &child : children) {
+        OGRRawPoint origin = ngsTileOrigin(child.first);
+        for(const auto &item : child.second->items()) {
+            if(!item.ids().empty()) {
+                features[item.ids()].push_back(std::make_pair(&item, origin));
+            }
+        }
+    }
+
+    OGRwkbGeometryType type = geometryType();
+    bool precisePixelSize = !(OGR_GT_Flatten(type) == wkbPoint ||
+                              OGR_GT_Flatten(type) == wkbMultiPoint);
+    double step = pixelSize(tile.z, precisePixelSize);
+    Envelope ext = tileEnvelope(tile);
+    ext.resize(TILE_RESIZE);
+
+    for(const auto &feature : features) {
+        GEOSGeometryPtr geom = GEOSGeometryWrap::createFromTileItems(
+                    feature.second, type);
+        if(!geom || !geom->isValid()) {
+            continue;
+        }
+        geom->simplify(step, m_simplifyType);
+
+        VectorTileItemArray items = tileGeometry(*feature.first.begin(), geom,
+                                                 tile, ext);
+        for(auto &item : items) {
+            for(auto id : feature.first) {
+                item.addId(id);
+            }
+        }
+        vtile.add(items, true);
+    }
+}
+
+// Point cluster grid cell
+using ClusterCell = std::pair<GIntBig, GIntBig>;
+
+static ClusterCell clusterCell(double x, double y, double cellSize)
+{
+    return std::make_pair(static_cast<GIntBig>(std::floor(x / cellSize)),
+                          static_cast<GIntBig>(std::floor(y / cellSize)));
+}
+
+// Tiles to store cluster point of zoom level
+static std::vector<TileItem> clusterTiles(unsigned char zoom, double x, double y)
+{
+    std::vector<TileItem> out;
+    Envelope env(x, y, x, y);
+    for(const auto &tileItem : MapTransform::getTilesForExtent(
+            FeatureClassOverview::extraExtentForZoom(zoom, env), zoom, false,
+            true)) {
+        Envelope ext = tileItem.env;
+        ext.resize(TILE_RESIZE);
+        if(ext.intersects(env)) {
+            out.push_back(tileItem);
+        }
+    }
+    return out;
+}
+
+// Cluster point is relative to the origin of each tile
+static VectorTileItem clusterItem(const Tile &tile, double x, double y,
+                                  const FeatureIdSet &ids)
+{
+    OGRRawPoint origin = ngsTileOrigin(tile);
+    VectorTileItem item;
+    item.addPoint({static_cast<float>(x - origin.x),
+                   static_cast<float>(y - origin.y)});
+    for(GIntBig id : ids) {
+        item.addId(id);
+    }
+    item.setValid(true);
+    return item;
+}
+
+template<class Function>
+static void forEachPoint(const OGRGeometry *geom, Function function)
+{
+    if(nullptr == geom) {
+        return;
+    }
+
+    switch(OGR_GT_Flatten(geom->getGeometryType())) {
+    case wkbPoint:
+        function(static_cast<const OGRPoint*>(geom));
+        break;
+    case wkbMultiPoint:
+    {
+        const OGRMultiPoint *mpt = static_cast<const OGRMultiPoint*>(geom);
+        for(int i = 0; i < mpt->getNumGeometries(); ++i) {
+            function(static_cast<const OGRPoint*>(mpt->getGeometryRef(i)));
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+
+// Cluster belongs to the cell if its member, except the edited feature, has
+// point in the cell.
+static bool clusterMemberInCell(const Table *table, const FeatureIdSet &ids,
+                                GIntBig fid, const ClusterCell &cell,
+                                double cellSize)
+{
+    size_t checks = 0;
+    for(GIntBig id : ids) {
+        if(id == fid) {
+            continue;
+        }
+        if(checks++ == CLUSTER_MEMBER_CHECKS) {
+            break;
+        }
+
+        FeaturePtr feature = table->getFeature(id);
+        if(!feature) {
+            continue;
+        }
+        bool inCell = false;
+        forEachPoint(feature->GetGeometryRef(), [&](const OGRPoint *pt) {
+            if(clusterCell(pt->getX(), pt->getY(), cellSize) == cell) {
+                inCell = true;
+            }
+        });
+        if(inCell) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double FeatureClassOverview::clusterCellSize(unsigned char zoom) const
+{
+    return pixelSize(zoom) * std::max(m_clusterRadius, 1.0);
+}
+
+/**
+ * @brief FeatureClassOverview::clusterPoints Aggregates points to clusters for
+ * all zoom levels in one pass over features. Points are grouped by grid cells
+ * of cluster radius pixels size. Cluster is stored as tile item with one point
+ * in members centroid and sorted member ids. If clusters exceed the memory
+ * budget, the most detailed zoom levels are left to the next passes.
+ * @param progress Progress to report.
+ * @return True on success.
+ */
+bool FeatureClassOverview::clusterPoints(const Progress &progress)
+{
+    struct PointCluster {
+        double sumX = 0.0, sumY = 0.0;
+        GIntBig count = 0;
+        FeatureIdSet ids;
+    };
+    using ClusterMap = std::map<ClusterCell, PointCluster>;
+    // Map node overhead included
+    const size_t clusterSize = sizeof(ClusterMap::value_type) +
+            4 * sizeof(void*);
+
+    std::vector<unsigned char> pending(m_zoomLevels.begin(),
+                                       m_zoomLevels.end());
+    double total = std::max(static_cast<double>(featureCount()), 1.0);
+    while(!pending.empty()) {
+        std::vector<unsigned char> zoomLevels(pending);
+        std::vector<double> cellSizes;
+        for(unsigned char zoomLevel : zoomLevels) {
+            cellSizes.push_back(clusterCellSize(zoomLevel));
+        }
+        std::vector<ClusterMap> clusters(zoomLevels.size());
+        std::vector<size_t> clusterSizes(zoomLevels.size(), 0);
+        size_t memorySize = 0;
+
+        auto addPoint = [&](GIntBig fid, const OGRPoint *pt) {
+            for(size_t i = 0; i < zoomLevels.size(); ++i) {
+                ClusterCell cell = clusterCell(pt->getX(), pt->getY(),
+                                               cellSizes[i]);
+                auto it = clusters[i].find(cell);
+                if(it == clusters[i].end()) {
+                    it = clusters[i].insert(
+                                std::make_pair(cell, PointCluster())).first;
+                    clusterSizes[i] += clusterSize;
+                    memorySize += clusterSize;
+                }
+                PointCluster &cluster = it->second;
+                size_t idsSize = cluster.ids.memorySize();
+                cluster.sumX += pt->getX();
+                cluster.sumY += pt->getY();
+                cluster.count++;
+                cluster.ids.insert(fid);
+                clusterSizes[i] += cluster.ids.memorySize() - idsSize;
+                memorySize += cluster.ids.memorySize() - idsSize;
+            }
+
+            // The most detailed zoom level has most clusters
+            while(m_memoryBudget > 0 && memorySize > m_memoryBudget &&
+                  zoomLevels.size() > 1) {
+                memorySize -= clusterSizes.back();
+                zoomLevels.pop_back();
+                cellSizes.pop_back();
+                clusters.pop_back();
+                clusterSizes.pop_back();
+            }
+        };
+
+        double counter = 0.0;
+        FeaturePtr feature;
+        while((feature = nextFeature())) {
+            GIntBig fid = feature->GetFID();
+            forEachPoint(feature->GetGeometryRef(), [&](const OGRPoint *pt) {
+                addPoint(fid, pt);
+            });
+
+            if(!progress.onProgress(COD_IN_PROCESS, ++counter / total,
+                                    _("Cluster points ..."))) {
+                return false;
+            }
+        }
+        reset();
+
+        for(size_t i = 0; i < zoomLevels.size(); ++i) {
+            unsigned char zoomLevel = zoomLevels[i];
+            for(const auto &cellCluster : clusters[i]) {
+                const PointCluster &cluster = cellCluster.second;
+                double x = cluster.sumX / cluster.count;
+                double y = cluster.sumY / cluster.count;
+                for(const auto &tileItem : clusterTiles(zoomLevel, x, y)) {
+                    VectorTileItemArray items = {
+                        clusterItem(tileItem.tile, x, y, cluster.ids) };
+                    addOverviewItem(tileItem.tile, items);
+                }
+            }
+            // Free memory at once
+            ClusterMap().swap(clusters[i]);
+        }
+
+        if(zoomLevels.size() < pending.size()) {
+            CPLDebug("ngstore", "Cluster points of %ld zoom levels in next pass",
+                     static_cast<long>(pending.size() - zoomLevels.size()));
+        }
+        pending.erase(pending.begin(),
+                      pending.begin() + static_cast<long>(zoomLevels.size()));
+    }
+    return true;
+}
+
+/**
+ * @brief FeatureClassOverview::updatePointClusters Updates clusters of the
+ * edited feature in pending tiles. Cluster of the grid cell is found by its
+ * point, as members centroid is always inside the cell. Members count is taken
+ * from the cluster ids, so centroids of multipoint clusters are approximate
+ * until overviews are rebuilt.
+ * @param fid Feature identifier.
+ * @param oldGeom Geometry before edit. May be null.
+ * @param newGeom Geometry after edit. May be null.
+ */
+void FeatureClassOverview::updatePointClusters(GIntBig fid,
+                                               const OGRGeometry *oldGeom,
+                                               const OGRGeometry *newGeom)
+{
+    struct CellChange {
+        double sumX = 0.0, sumY = 0.0;
+        int removed = 0, added = 0;
+    };
+    using ClusterCandidate = std::pair<FeatureIdSet, OGRRawPoint>;
+
+    for(unsigned char zoomLevel : zoomLevels()) {
+        double cellSize = clusterCellSize(zoomLevel);
+        std::map<ClusterCell, CellChange> changes;
+        forEachPoint(oldGeom, [&](const OGRPoint *pt) {
+            CellChange &change = changes[clusterCell(pt->getX(), pt->getY(),
+                                                     cellSize)];
+            change.sumX -= pt->getX();
+            change.sumY -= pt->getY();
+            change.removed++;
+        });
+        forEachPoint(newGeom, [&](const OGRPoint *pt) {
+            CellChange &change = changes[clusterCell(pt->getX(), pt->getY(),
+                                                     cellSize)];
+            change.sumX += pt->getX();
+            change.sumY += pt->getY();
+            change.added++;
+        });
+
+        for(const auto &changeItem : changes) {
+            const ClusterCell &cell = changeItem.first;
+            const CellChange &change = changeItem.second;
+            if(change.removed == change.added && change.sumX == 0.0 &&
+               change.sumY == 0.0) {
+                continue; // Points of the cell are not moved
+            }
+
+            // Stored cluster centroid is quantized and may lie over the cell
+            // edge, so clusters near the cell are matched by member ids.
+            Envelope cellEnv(cell.first * cellSize, cell.second * cellSize,
+                             (cell.first + 1) * cellSize,
+                             (cell.second + 1) * cellSize);
+            Envelope nearEnv = cellEnv;
+            nearEnv.resize(1.0 + CLUSTER_CELL_TOLERANCE);
+            std::map<Tile, VectorTilePtr> storedTiles;
+            std::vector<ClusterCandidate> candidates;
+            for(const auto &tileItem : MapTransform::getTilesForExtent(
+                    extraExtentForZoom(zoomLevel, cellEnv), zoomLevel, false,
+                    true)) {
+                VectorTilePtr vtile = getTileInternal(tileItem.tile);
+                storedTiles[tileItem.tile] = vtile;
+                OGRRawPoint origin = ngsTileOrigin(tileItem.tile);
+                for(const auto &item : vtile->items()) {
+                    if(item.pointCount() != 1) {
+                        continue;
+                    }
+                    OGRRawPoint pt(item.point(0).x + origin.x,
+                                   item.point(0).y + origin.y);
+                    if(nearEnv.contains(Envelope(pt.x, pt.y, pt.x, pt.y))) {
+                        candidates.push_back(std::make_pair(item.ids(), pt));
+                    }
+                }
+            }
+            // Clusters with centroid in the cell are checked first
+            std::stable_partition(candidates.begin(), candidates.end(),
+                                  [&](const ClusterCandidate &candidate) {
+                return clusterCell(candidate.second.x, candidate.second.y,
+                                   cellSize) == cell;
+            });
+
+            // Cluster holding the edited feature, nearest to the cell centre,
+            // or cluster, which other member has point in the cell.
+            const ClusterCandidate *found = nullptr;
+            OGRRawPoint center = cellEnv.center();
+            for(const auto &candidate : candidates) {
+                if(change.removed > 0) {
+                    if(candidate.first.contains(fid) &&
+                       (nullptr == found ||
+                        ngsDistance(candidate.second, center) <
+                        ngsDistance(found->second, center))) {
+                        found = &candidate;
+                    }
+                }
+                else if(clusterMemberInCell(this, candidate.first, fid, cell,
+                                            cellSize)) {
+                    found = &candidate;
+                    break;
+                }
+            }
+
+            // Take the cluster out of tiles around the cell
+            std::map<Tile, VectorTile> tiles;
+            std::set<Tile> changedTiles;
+            double sumX = 0.0, sumY = 0.0;
+            FeatureIdSet ids;
+            if(nullptr != found) {
+                ids = found->first;
+                sumX = found->second.x * ids.size();
+                sumY = found->second.y * ids.size();
+            }
+            for(const auto &storedTile : storedTiles) {
+                VectorTile out;
+                bool removed = false;
+                for(const auto &item : storedTile.second->items()) {
+                    if(nullptr != found && item.pointCount() == 1 &&
+                       item.ids() == ids) {
+                        removed = true;
+                        continue;
+                    }
+                    out.add(item, false);
+                }
+
+                if(removed) {
+                    tiles[storedTile.first] = out;
+                    changedTiles.insert(storedTile.first);
+                }
+                else {
+                    tiles[storedTile.first] = *storedTile.second;
+                }
+            }
+
+            // Put the changed cluster back
+            GIntBig count = static_cast<GIntBig>(ids.size()) - change.removed +
+                    change.added;
+            sumX += change.sumX;
+            sumY += change.sumY;
+            if(change.added > 0) {
+                ids.insert(fid);
+            }
+            else {
+                ids.erase(fid);
+            }
+
+            if(count > 0 && !ids.empty()) {
+                double x = sumX / count;
+                double y = sumY / count;
+                for(const auto &tileItem : clusterTiles(zoomLevel, x, y)) {
+                    auto it = tiles.find(tileItem.tile);
+                    if(it == tiles.end()) {
+                        it = tiles.insert(std::make_pair(tileItem.tile,
+                                *getTileInternal(tileItem.tile))).first;
+                    }
+                    it->second.add(clusterItem(tileItem.tile, x, y, ids), true);
+                    changedTiles.insert(tileItem.tile);
+                }
+            }
+
+            for(const auto &tile : changedTiles) {
+                setDirtyTile(tile, tiles[tile]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief FeatureClassOverview::buildPyramid Saves tiles of the most detailed
+ * zoom level and builds each coarser level from the previous one.
+ * @param progress Progress to report.
+ * @return True on success.
+ */
+bool FeatureClassOverview::buildPyramid(const Progress &progress)
+{
+    std::map<Tile, VectorTile> level;
+    for(auto &item : m_genTiles) {
+        Tile tile = ngsTileFromKey(item.first);
+        tile.crossExtent = 0;
+        level[tile].add(item.second.items(), true);
+    }
+    m_genTiles.clear();
+
+    unsigned char levelZoom = *m_zoomLevels.rbegin();
+    double levelCount = m_zoomLevels.size();
+    double levelIndex = 0.0;
+    for(auto it = m_zoomLevels.rbegin(); it != m_zoomLevels.rend(); ++it) {
+        // Build level from previous one
+        if(*it != levelZoom) {
+            int shift = levelZoom - *it;
+            std::map<Tile, std::vector<VectorTileRef>> parents;
+            for(const auto &item : level) {
+                Tile parent = {item.first.x >> shift, item.first.y >> shift,
+                               *it, 0};
+                parents[parent].push_back(std::make_pair(item.first,
+                                                         &item.second));
+            }
+
+            std::vector<VectorTile> parentTiles(parents.size());
+            ThreadPool threadPool;
+            threadPool.init(getNumberThreads(), pyramidTileThreadFunc);
+            size_t index = 0;
+            for(const auto &parent : parents) {
+                threadPool.addThreadData(new PyramidTileData(this, parent.first,
+                    parent.second, &parentTiles[index++], true));
+            }
+            threadPool.waitComplete(Progress(), PARALLEL_TILING_CHECK_INTERVAL);
+            threadPool.clearThreadData();
+
+            std::map<Tile, VectorTile> newLevel;
+            index = 0;
+            for(const auto &parent : parents) {
+                newLevel[parent.first] = std::move(parentTiles[index++]);
+            }
+            level.swap(newLevel);
+            levelZoom = *it;
+        }
+
+        // Save level tiles
+        double counter = 0.0;
+        for(auto &item : level) {
+            if(!saveOverviewTile(item.first, item.second) ||
+               !progress.onProgress(COD_IN_PROCESS,
+                                    (levelIndex + counter / level.size()) /
+                                    levelCount, _("Save tiles ..."))) {
+                return false;
+            }
+            counter++;
+        }
+        levelIndex++;
+    }
+
+    return true;
+}
+
+void FeatureClassOverview::clearOverviewRuns()
+{
+    for(const auto &path : m_ovrRuns) {
+        File::deleteFile(path);
+    }
+    m_ovrRuns.clear();
+    m_checkpointRuns = 0;
+}
+
+/**
+ * @brief FeatureClassOverview::releaseOverviewRuns Deletes runs flushed after
+ * the last checkpoint. Runs saved at checkpoint are kept on disk to resume
+ * the build.
+ */
+void FeatureClassOverview::releaseOverviewRuns()
+{
+    while(m_ovrRuns.size() > m_checkpointRuns) {
+        File::deleteFile(m_ovrRuns.back());
+        m_ovrRuns.pop_back();
+    }
+    m_ovrRuns.clear();
+    m_checkpointRuns = 0;
 }
 
 } // namespace ngs
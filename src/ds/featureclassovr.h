@@ -21,12 +21,77 @@
 #ifndef NGSFEATUREDATASETOVR_H
 #define NGSFEATUREDATASETOVR_H
 
+#include <list>
+
 #include "featureclass.h"
+#include "tilestore.h"
 
 namespace ngs {
 
 constexpr double TILE_RESIZE = 1.1;
 
+class TilingData;
+// Tile data and its position, tile items are relative to the tile origin
+using VectorTileRef = std::pair<Tile, const VectorTile*>;
+// Decoded tiles are shared between the cache and readers without a copy
+using VectorTilePtr = std::shared_ptr<const VectorTile>;
+
+/**
+ * @brief The VectorTileCache class. Size bounded LRU cache of decoded tiles.
+ */
+class VectorTileCache
+{
+public:
+    explicit VectorTileCache(size_t maxSize);
+    VectorTilePtr get(const Tile &tile);
+    bool put(const Tile &tile, VectorTilePtr vtile, GUIntBig generation);
+    GUIntBig generation() const;
+    bool contains(const Tile &tile) const;
+    void remove(const Tile &tile);
+    void clear();
+    GUIntBig hits() const { return m_hits; }
+    GUIntBig misses() const { return m_misses; }
+    size_t size() const { return m_size; }
+    size_t maxSize() const { return m_maxSize; }
+
+private:
+    struct CacheItem {
+        Tile tile;
+        VectorTilePtr vtile;
+        size_t size;
+    };
+    using CacheItems = std::list<CacheItem>;
+
+private:
+    CacheItems m_items;
+    std::map<Tile, CacheItems::iterator> m_index;
+    size_t m_size;
+    size_t m_maxSize;
+    GUIntBig m_hits;
+    GUIntBig m_misses;
+    GUIntBig m_generation;
+    Mutex m_mutex;
+};
+
+/**
+ * @brief The TilePresenceFilter class. Bloom filter over tile keys of one zoom
+ * level. Answers if the tile is surely absent or may be present.
+ */
+class TilePresenceFilter
+{
+public:
+    explicit TilePresenceFilter(size_t tileCount = 0);
+    void add(int x, int y);
+    bool mayContain(int x, int y) const;
+    bool isValid() const { return !m_bits.empty(); }
+    BufferPtr save() const;
+    bool load(Buffer &buffer);
+
+private:
+    std::vector<GUIntBig> m_bits;
+    unsigned char m_hashCount;
+};
+
 /**
  * @brief The FeatureClassOverview class
  */
@@ -37,24 +102,33 @@ public:
                           ObjectContainer * const parent = nullptr,
                           const enum ngsCatalogObjectType type = CAT_FC_ANY,
                           const std::string &name = "");
-    virtual ~FeatureClassOverview() override = default;
+    virtual ~FeatureClassOverview() override;
     virtual bool onRowsCopied(const TablePtr srcTable,
                               const Progress &progress = Progress(),
                               const Options &options = Options()) override;
     bool hasOverviews() const;
     bool createOverviews(const Progress &progress = Progress(),
                          const Options &options = Options());
-    VectorTile getTile(const Tile &tile, const Envelope &tileExtent = Envelope());
+    VectorTilePtr getTile(const Tile &tile,
+                          const Envelope &tileExtent = Envelope());
+    void cacheTiles(const std::vector<TileItem> &tiles);
     std::set<unsigned char> zoomLevels() const { return m_zoomLevels; }
     void addOverviewItem(const Tile &tile, const VectorTileItemArray &items);
+    GUIntBig tileCacheHits() const { return m_tileCache.hits(); }
+    GUIntBig tileCacheMisses() const { return m_tileCache.misses(); }
+    bool flushDirtyTiles();
+    size_t dirtyTilesCount() const;
+    bool hasPointClusters() const { return m_clusterPoints; }
 
     // static
     static double pixelSize(int zoom, bool precize = false);
     static Envelope extraExtentForZoom(unsigned char zoom, const Envelope &env);
+    static double extraSizeForZoom(unsigned char zoom);
 
     // Object interface
 public:
     virtual bool destroy() override;
+    virtual bool sync() override;
 
     // Table interface
 protected:
@@ -65,8 +139,26 @@ protected:
 
 protected:
     VectorTileItemArray tileGeometry(GIntBig fid, GEOSGeometryPtr geom,
-                                     const Envelope &env) const;
+                                     const Tile &tile, const Envelope &env) const;
+    void tileFeature(FeaturePtr feature, double step, const Tile &tile,
+                     const Envelope &extent, VectorTileItemArray &items) const;
+    void tileFeatureZooms(FeaturePtr feature,
+                          const std::set<unsigned char> &zoomLevels,
+                          std::map<Tile, VectorTile> &tiles) const;
+    bool tileFeatures(const Progress &progress, unsigned char threadCount);
+    void queuePartitions(ThreadPool &threadPool,
+                         std::vector<std::unique_ptr<TilingData>> &partitions,
+                         std::list<std::unique_ptr<TilingData>> &queued);
+    bool checkpoint(const Progress &progress, ThreadPool &threadPool,
+                    std::vector<std::unique_ptr<TilingData>> &partitions,
+                    std::list<std::unique_ptr<TilingData>> &queued,
+                    GIntBig lastFid);
+    void mergeTilingData(std::list<std::unique_ptr<TilingData>> &queued);
+    void addGenTileItems(const Tile &tile, const VectorTileItemArray &items);
     void fillZoomLevels(const std::string &zoomLevels = "");
+    static std::vector<TileItem> tilesForUpdate(const OGRGeometry *oldGeom,
+                                                const OGRGeometry *newGeom,
+                                                unsigned char zoom);
 
 /*
     void tileLine(GIntBig fid, OGRGeometry* geom, OGRGeometry* extent,
@@ -81,22 +173,85 @@ protected:
 
     bool hasTilesTable();
     FeaturePtr getTileFeature(const Tile &tile);
-    VectorTile getTileInternal(const Tile &tile);
+    VectorTilePtr getTileInternal(const Tile &tile);
+    VectorTilePtr getNearestTile(const Tile &tile);
+    void removeNearestTiles(const Tile &tile);
+    void clipParentTile(const Tile &tile, const Tile &parentTile,
+                        const VectorTile &parent, VectorTile &vtile) const;
     bool setTileFeature(FeaturePtr tile);
     bool createTileFeature(FeaturePtr tile);
+    OverviewTileStore *tileStore();
+    VectorTile loadTile(const Tile &tile);
+    bool getDirtyTile(const Tile &tile, VectorTile &vtile) const;
+    bool dirtyTileExists(const Tile &tile) const;
+    void setDirtyTile(const Tile &tile, const VectorTile &vtile);
+    bool writeTile(const Tile &tile, const VectorTile &vtile);
+    bool writeTileData(const Tile &tile, const GByte *data, size_t size);
+    bool readTileData(const Tile &tile, std::vector<GByte> &data);
+    bool tileMayExist(const Tile &tile);
+    bool loadPresenceFilter(unsigned char zoom,
+                            TilePresenceFilter &filter) const;
+    bool storePresenceFilter(unsigned char zoom,
+                             const TilePresenceFilter &filter);
+    bool buildPresenceFilters();
+    bool savePresenceFilters();
+    void clearPresenceFilters();
+    BufferPtr saveTile(const Tile &tile, const VectorTile &vtile) const;
+    bool saveOverviewTile(const Tile &tile, VectorTile &vtile);
+    bool flushOverviewRun();
+    bool mergeOverviewRuns(const Progress &progress);
+    bool overviewsFailed(const Progress &progress, enum ngsCode code,
+                         const std::string &message);
+    bool clusterPoints(const Progress &progress);
+    double clusterCellSize(unsigned char zoom) const;
+    void updatePointClusters(GIntBig fid, const OGRGeometry *oldGeom,
+                             const OGRGeometry *newGeom);
+    bool buildPyramid(const Progress &progress);
+    void buildPyramidTile(const Tile &tile,
+                          const std::vector<VectorTileRef> &children,
+                          VectorTile &vtile) const;
+    void clearOverviewRuns();
+    void releaseOverviewRuns();
 
     // static
 protected:
     static bool tilingDataJobThreadFunc(ThreadData *threadData);
+    static bool tileFeatureThreadFunc(ThreadData *threadData);
+    static bool pyramidTileThreadFunc(ThreadData *threadData);
+    static Envelope tileEnvelope(const Tile &tile);
 
 protected:
     OGRLayer *m_ovrTable;
     std::set<unsigned char> m_zoomLevels;
     Mutex m_genTileMutex;
     bool m_creatingOvr;
+    bool m_compressTiles;
+    GEOSGeometryWrap::SimplifyType m_simplifyType;
+    bool m_clusterPoints;
+    double m_clusterRadius;
+    bool m_ovrReady;
+    VectorTileCache m_tileCache;
+    std::map<Tile, VectorTile> m_dirtyTiles;
+    std::map<Tile, VectorTile> m_flushTiles;
+    Mutex m_dirtyTilesMutex;
+    size_t m_dirtyTilesLimit;
+    OverviewTileStorePtr m_tileStore;
+    Mutex m_tileStoreMutex;
+    ThreadPool m_tilingPool;
 
 private:
-    std::map<Tile, VectorTile> m_genTiles;
+    std::unordered_map<TileKey, VectorTile> m_genTiles;
+    size_t m_genTilesSize;
+    size_t m_memoryBudget;
+    size_t m_checkpointFeatures;
+    GIntBig m_checkpointFid;
+    size_t m_checkpointRuns;
+    std::map<unsigned char, TilePresenceFilter> m_presenceFilters;
+    Mutex m_presenceMutex;
+    bool m_presenceLoaded;
+    bool m_presenceChanged;
+    std::vector<std::string> m_ovrRuns;
+    bool m_pyramidBuild;
 };
 
 using FeatureClassOverviewPtr = std::shared_ptr<FeatureClassOverview>;
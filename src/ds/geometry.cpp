@@ -20,10 +20,15 @@
  ****************************************************************************/
 #include "geometry.h"
 
+// std
+#include <queue>
+#include <stack>
+
 #include "earcut.hpp"
 #include "geos_c.h"
 
 #include "api_priv.h"
+#include "util/stringutil.h"
 
 namespace ngs {
 
@@ -36,6 +41,16 @@ constexpr const char *MAP_MAX_Y_KEY = "max_y";
 
 constexpr unsigned short MAX_EDGE_INDEX = 65534;
 
+// Vector tile blob header. Version 1 blobs have no header.
+constexpr GUInt32 TILE_MAGIC = 0x3254474E; // NGT2
+constexpr GByte TILE_FLAG_DEFLATE = 0x01;
+constexpr GByte TILE_FLAG_ID_RANGES = 0x02;
+// Coordinates are relative to the tile origin. Older blobs have absolute ones.
+constexpr GByte TILE_FLAG_LOCAL_COORDS = 0x04;
+constexpr size_t MAX_TILE_SIZE = 256 * 1024 * 1024;
+// Relative tolerance of clipped holes area equal to the clipped exterior area
+constexpr double CLIP_AREA_EPSILON = 1e-9;
+
 //------------------------------------------------------------------------------
 // GeometryPtr
 //------------------------------------------------------------------------------
@@ -61,6 +76,166 @@ ngs::GeometryPtr::operator OGRGeometry *() const
      return get();
 }
 
+//------------------------------------------------------------------------------
+// FeatureIdSet
+//------------------------------------------------------------------------------
+
+void FeatureIdSet::insert(GIntBig id)
+{
+    if(0 == m_count) {
+        m_id = id;
+        m_count = 1;
+        return;
+    }
+
+    if(1 == m_count) {
+        if(m_id == id) {
+            return;
+        }
+        m_ids.reserve(2);
+        m_ids.push_back(std::min(m_id, id));
+        m_ids.push_back(std::max(m_id, id));
+        m_count = 2;
+        return;
+    }
+
+    // Ids are mostly added in ascending order
+    if(id > m_ids.back()) {
+        m_ids.push_back(id);
+    }
+    else {
+        auto it = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+        if(*it == id) {
+            return;
+        }
+        m_ids.insert(it, id);
+    }
+    m_count = m_ids.size();
+}
+
+bool FeatureIdSet::erase(GIntBig id)
+{
+    if(1 == m_count) {
+        if(m_id != id) {
+            return false;
+        }
+        m_count = 0;
+        return true;
+    }
+
+    auto it = std::lower_bound(m_ids.begin(), m_ids.end(), id);
+    if(it == m_ids.end() || *it != id) {
+        return false;
+    }
+    m_ids.erase(it);
+    m_count = m_ids.size();
+    if(1 == m_count) {
+        m_id = m_ids.front();
+        std::vector<GIntBig>().swap(m_ids);
+    }
+    return true;
+}
+
+/**
+ * @brief FeatureIdSet::normalize Sorts and removes duplicates from appended
+ * ids. Single id is moved to the inline storage.
+ */
+void FeatureIdSet::normalize()
+{
+    if(!std::is_sorted(m_ids.begin(), m_ids.end())) {
+        std::sort(m_ids.begin(), m_ids.end());
+    }
+    m_ids.erase(std::unique(m_ids.begin(), m_ids.end()), m_ids.end());
+    m_count = m_ids.size();
+    if(1 == m_count) {
+        m_id = m_ids.front();
+        std::vector<GIntBig>().swap(m_ids);
+    }
+}
+
+void FeatureIdSet::clear()
+{
+    std::vector<GIntBig>().swap(m_ids);
+    m_count = 0;
+}
+
+bool FeatureIdSet::contains(GIntBig id) const
+{
+    return std::binary_search(begin(), end(), id);
+}
+
+/**
+ * @brief FeatureIdSet::intersects Checks if sets have common ids. The ids of
+ * smaller set are searched in bigger one, so small tile item sets are checked
+ * against large hide or selection sets in logarithmic time.
+ * @param other Set to check.
+ * @return True if at least one id is present in both sets.
+ */
+bool FeatureIdSet::intersects(const FeatureIdSet &other) const
+{
+    const FeatureIdSet &small = m_count <= other.m_count ? *this : other;
+    const FeatureIdSet &big = m_count <= other.m_count ? other : *this;
+    if(small.empty() || small.m_count * 4 < big.m_count) {
+        for(GIntBig id : small) {
+            if(big.contains(id)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const_iterator first1 = begin(), last1 = end();
+    const_iterator first2 = other.begin(), last2 = other.end();
+    while(first1 != last1 && first2 != last2) {
+        if(*first1 < *first2) {
+            ++first1;
+        }
+        else if(*first2 < *first1) {
+            ++first2;
+        }
+        else {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief FeatureIdSet::isSubsetOf Checks if all ids are present in other set.
+ * @param other Set to check.
+ * @return True if all ids are present in other set.
+ */
+bool FeatureIdSet::isSubsetOf(const FeatureIdSet &other) const
+{
+    if(m_count > other.m_count) {
+        return false;
+    }
+    if(m_count * 4 < other.m_count) {
+        for(GIntBig id : *this) {
+            if(!other.contains(id)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return std::includes(other.begin(), other.end(), begin(), end());
+}
+
+FeatureIdSet FeatureIdSet::intersection(const FeatureIdSet &other) const
+{
+    FeatureIdSet out;
+    std::vector<GIntBig> common;
+    std::set_intersection(begin(), end(), other.begin(), other.end(),
+                          std::back_inserter(common));
+    out.insert(common.begin(), common.end());
+    return out;
+}
+
+size_t FeatureIdSet::memorySize() const
+{
+    return m_ids.capacity() * sizeof(GIntBig);
+}
+
 //------------------------------------------------------------------------------
 // VectorTileItem
 //------------------------------------------------------------------------------
@@ -73,12 +248,8 @@ VectorTileItem::VectorTileItem() :
 
 void VectorTileItem::removeId(GIntBig id)
 {
-    auto it = m_ids.find(id);
-    if(it != m_ids.end()) {
-        m_ids.erase(it);
-        if(m_ids.empty()) {
-            m_valid = false;
-        }
+    if(m_ids.erase(id) && m_ids.empty()) {
+        m_valid = false;
     }
 }
 
@@ -93,54 +264,193 @@ void VectorTileItem::addBorderIndex(unsigned short ring, unsigned short index)
     m_borderIndices[ring].push_back(index);
 }
 
-void VectorTileItem::save(Buffer *buffer)
+static GUIntBig zigzag(GIntBig val)
 {
-    buffer->put(static_cast<GByte>(m_2d));
+    return (static_cast<GUIntBig>(val) << 1) ^ static_cast<GUIntBig>(val >> 63);
+}
 
-    // vector<SimplePoint> m_points
-    buffer->put(static_cast<GUInt32>(m_points.size()));
-    for(auto point : m_points) {
-        if(m_2d) {
+static GIntBig unzigzag(GUIntBig val)
+{
+    return static_cast<GIntBig>(val >> 1) ^ -static_cast<GIntBig>(val & 1);
+}
+
+static void updateMinimum(double &minX, double &minY,
+                          const std::vector<SimplePoint> &points)
+{
+    for(const auto &point : points) {
+        minX = std::min(minX, static_cast<double>(point.x));
+        minY = std::min(minY, static_cast<double>(point.y));
+    }
+}
+
+static void putPoints(Buffer *buffer, const std::vector<SimplePoint> &points,
+                      const OGRRawPoint &origin, double step)
+{
+    buffer->putVarint(points.size());
+    if(step > 0.0) {
+        GIntBig prevX = 0, prevY = 0;
+        for(const auto &point : points) {
+            GIntBig x = static_cast<GIntBig>(std::llround(
+                (static_cast<double>(point.x) - origin.x) / step));
+            GIntBig y = static_cast<GIntBig>(std::llround(
+                (static_cast<double>(point.y) - origin.y) / step));
+            buffer->putVarint(zigzag(x - prevX));
+            buffer->putVarint(zigzag(y - prevY));
+            prevX = x;
+            prevY = y;
+        }
+    }
+    else {
+        for(const auto &point : points) {
             buffer->put(point.x);
             buffer->put(point.y);
         }
-        else {
-            // TODO: Add point with z support
+    }
+}
+
+static bool getPoints(Buffer &buffer, std::vector<SimplePoint> &points,
+                      const OGRRawPoint &origin, double step)
+{
+    GUIntBig size = buffer.getVarint();
+    if(size > static_cast<GUIntBig>(buffer.size())) {
+        return false;
+    }
+    points.reserve(static_cast<size_t>(size));
+    if(step > 0.0) {
+        GIntBig x = 0, y = 0;
+        for(GUIntBig i = 0; i < size; ++i) {
+            x += unzigzag(buffer.getVarint());
+            y += unzigzag(buffer.getVarint());
+            SimplePoint pt = {static_cast<float>(origin.x + x * step),
+                              static_cast<float>(origin.y + y * step)};
+            points.push_back(pt);
+        }
+    }
+    else {
+        for(GUIntBig i = 0; i < size; ++i) {
+            float x = buffer.getFloat();
+            float y = buffer.getFloat();
+            SimplePoint pt = {x, y};
+            points.push_back(pt);
         }
     }
+    return true;
+}
 
-    // vector<unsigned short> m_indices
-    buffer->put(static_cast<GUInt32>(m_indices.size()));
-    for(auto index : m_indices) {
-        buffer->put(index);
+static void putIndices(Buffer *buffer, const std::vector<unsigned short> &indices)
+{
+    buffer->putVarint(indices.size());
+    GIntBig prev = 0;
+    for(auto index : indices) {
+        buffer->putVarint(zigzag(index - prev));
+        prev = index;
     }
+}
 
-    //vector<vector<unsigned short>> m_borderIndices
-    buffer->put(static_cast<GUInt32>(m_borderIndices.size()));
-    for(auto borderIndexArray : m_borderIndices) {
-        buffer->put(static_cast<GUInt32>(borderIndexArray.size()));
-        for(auto borderIndex : borderIndexArray) {
-            buffer->put(borderIndex);
-        }
+static bool getIndices(Buffer &buffer, std::vector<unsigned short> &indices)
+{
+    GUIntBig size = buffer.getVarint();
+    if(size > static_cast<GUIntBig>(buffer.size())) {
+        return false;
+    }
+    indices.reserve(static_cast<size_t>(size));
+    GIntBig index = 0;
+    for(GUIntBig i = 0; i < size; ++i) {
+        index += unzigzag(buffer.getVarint());
+        indices.push_back(static_cast<unsigned short>(index));
     }
+    return true;
+}
 
-    // vector<SimplePoint> m_centroids
-    buffer->put(static_cast<GUInt32>(m_centroids.size()));
-    for(auto centroid : m_centroids) {
-        if(m_2d) {
-            buffer->put(centroid.x);
-            buffer->put(centroid.y);
+void VectorTileItem::save(Buffer *buffer, const OGRRawPoint &origin,
+                          double step) const
+{
+    buffer->put(static_cast<GByte>(m_2d));
+
+    putPoints(buffer, m_points, origin, step);
+    putIndices(buffer, m_indices);
+
+    buffer->putVarint(m_borderIndices.size());
+    for(const auto &borderIndexArray : m_borderIndices) {
+        putIndices(buffer, borderIndexArray);
+    }
+
+    putPoints(buffer, m_centroids, origin, step);
+
+    // Ids are sorted, so store ranges of consecutive ids as difference with
+    // previous range end and range length. Point clusters have long ranges.
+    std::vector<std::pair<GIntBig, GUIntBig>> ranges;
+    for(auto id : m_ids) {
+        if(!ranges.empty() &&
+                ranges.back().first + static_cast<GIntBig>(ranges.back().second) == id) {
+            ranges.back().second++;
         }
         else {
-            // TODO: Add point with z support
+            ranges.push_back(std::make_pair(id, 1));
         }
     }
 
-    // set<GIntBig> m_ids
-    buffer->put(static_cast<GUInt32>(m_ids.size()));
-    for(auto id : m_ids) {
-        buffer->put(id);
+    buffer->putVarint(ranges.size());
+    GIntBig prev = 0;
+    for(const auto &range : ranges) {
+        buffer->putVarint(zigzag(range.first - prev));
+        buffer->putVarint(range.second - 1);
+        prev = range.first + static_cast<GIntBig>(range.second) - 1;
+    }
+}
+
+bool VectorTileItem::load(Buffer &buffer, bool idRanges,
+                          const OGRRawPoint &origin, double step)
+{
+    m_2d = buffer.getByte();
+
+    if(!getPoints(buffer, m_points, origin, step) ||
+       !getIndices(buffer, m_indices)) {
+        return false;
+    }
+
+    GUIntBig size = buffer.getVarint();
+    if(size > static_cast<GUIntBig>(buffer.size())) {
+        return false;
+    }
+    for(GUIntBig i = 0; i < size; ++i) {
+        std::vector<unsigned short> array;
+        if(!getIndices(buffer, array)) {
+            return false;
+        }
+        if(!array.empty()) {
+            m_borderIndices.push_back(array);
+        }
+    }
+
+    if(!getPoints(buffer, m_centroids, origin, step)) {
+        return false;
+    }
+
+    size = buffer.getVarint();
+    if(size > static_cast<GUIntBig>(buffer.size())) {
+        return false;
+    }
+    GIntBig id = 0;
+    for(GUIntBig i = 0; i < size; ++i) {
+        id += unzigzag(buffer.getVarint());
+        if(!idRanges) {
+            m_ids.insert(id);
+            continue;
+        }
+
+        GUIntBig length = buffer.getVarint();
+        if(length > MAX_TILE_SIZE) {
+            return false;
+        }
+        for(GUIntBig j = 0; j < length; ++j) {
+            m_ids.insert(id++);
+        }
+        m_ids.insert(id);
     }
+
+    m_valid = true;
+    return true;
 }
 
 bool VectorTileItem::load(Buffer &buffer)
@@ -193,7 +503,7 @@ bool VectorTileItem::load(Buffer &buffer)
         }
     }
 
-    // set<GIntBig> m_ids
+    // Sorted ids
     size = buffer.getULong();
     for(GUInt32 i = 0; i < size; ++i) {
         m_ids.insert(buffer.getBig());
@@ -211,80 +521,135 @@ bool VectorTileItem::isClosed() const
 
 void VectorTileItem::loadIds(const VectorTileItem &item)
 {
-    for(GIntBig id : item.m_ids) {
-        m_ids.insert(id);
+    m_ids.insert(item.m_ids.begin(), item.m_ids.end());
+}
+
+/**
+ * @brief VectorTileItem::hash Computes FNV-1a hash of item points.
+ * @return 64-bit hash. Equal items have equal hashes.
+ */
+GUInt64 VectorTileItem::hash() const
+{
+    GUInt64 out = 14695981039346656037ULL;
+    for(const auto &pt : m_points) {
+        // Add zero to make -0.0 and 0.0 equal as operator== does
+        float coords[2] = { pt.x + 0.0f, pt.y + 0.0f };
+        const GByte *data = reinterpret_cast<const GByte*>(coords);
+        for(size_t i = 0; i < sizeof(coords); ++i) {
+            out ^= data[i];
+            out *= 1099511628211ULL;
+        }
     }
+    return out;
 }
 
-bool VectorTileItem::isIdsPresent(const std::set<GIntBig> &other, bool full) const
+bool VectorTileItem::isIdsPresent(const FeatureIdSet &other, bool full) const
 {
     if(other.empty()) {
         return false;
     }
     if(full) {
-        return  std::includes(other.begin(), other.end(),
-                             m_ids.begin(), m_ids.end());
-    }
-    else {
-        for(auto id : other) {
-            if(m_ids.find(id) != m_ids.end()) {
-                return true;
-            }
-        }
-//        result = std::search(other.begin(), other.end(),
-//                           m_ids.begin(), m_ids.end()) != other.end();
+        return m_ids.isSubsetOf(other);
     }
-
-    return false;
+    return m_ids.intersects(other);
 }
-std::set<GIntBig> VectorTileItem::idsIntesect(const std::set<GIntBig> &other) const
+
+FeatureIdSet VectorTileItem::idsIntesect(const FeatureIdSet &other) const
 {
-    std::set<GIntBig> common_data;
-    if(other.empty())
-        return common_data;
-    std::set_intersection(other.begin(), other.end(),
-                          m_ids.begin(), m_ids.end(),
-                          std::inserter(common_data, common_data.begin()));
-    return common_data;
+    return m_ids.intersection(other);
 }
 
+size_t VectorTileItem::memorySize() const
+{
+    // Approximate heap usage
+    size_t size = sizeof(VectorTileItem);
+    size += m_points.capacity() * sizeof(SimplePoint);
+    size += m_indices.capacity() * sizeof(unsigned short);
+    for(const auto &borderIndexArray : m_borderIndices) {
+        size += sizeof(borderIndexArray) +
+                borderIndexArray.capacity() * sizeof(unsigned short);
+    }
+    size += m_centroids.capacity() * sizeof(SimplePoint);
+    size += m_ids.memorySize();
+    return size;
+}
 
 //------------------------------------------------------------------------------
 // VectorTile
 //------------------------------------------------------------------------------
 
-void VectorTile::add(const VectorTileItem &item, bool checkDuplicates)
+/**
+ * @brief VectorTile::add Adds item to tile. Ids of item equal to existing one
+ * are merged into it.
+ * @param item Item to add.
+ * @param checkDuplicates Look for equal item.
+ * @return Approximate memory size the tile grows by.
+ */
+size_t VectorTile::add(const VectorTileItem &item, bool checkDuplicates)
 {
     if(!item.isValid()) {
-        return;
+        return 0;
     }
+    size_t size = 0;
     if(checkDuplicates) {
-        auto it = std::find(m_items.begin(), m_items.end(), item);
+        GUInt64 hash = item.hash();
+        auto it = findItem(item, hash);
         if(it == m_items.end()) {
+            m_index.insert(std::make_pair(hash, m_items.size()));
             m_items.push_back(item);
+            m_indexedCount = m_items.size();
+            size = item.memorySize() + sizeof(GUInt64) + sizeof(size_t);
         }
         else {
+            size_t oldSize = (*it).memorySize();
             (*it).loadIds(item);
+            size_t newSize = (*it).memorySize();
+            size = newSize > oldSize ? newSize - oldSize : 0;
         }
     }
     else {
         m_items.push_back(item);
+        size = item.memorySize();
     }
 
     if(!m_valid) {
         m_valid = !m_items.empty();
     }
+    return size;
 }
 
-void VectorTile::add(const VectorTileItemArray &items, bool checkDuplicates)
+size_t VectorTile::add(const VectorTileItemArray &items, bool checkDuplicates)
 {
+    size_t size = 0;
     for(const auto &item : items) {
-        add(item, checkDuplicates);
+        size += add(item, checkDuplicates);
+    }
+    return size;
+}
+
+VectorTileItemArray::iterator VectorTile::findItem(const VectorTileItem &item,
+                                                   GUInt64 hash)
+{
+    for(; m_indexedCount < m_items.size(); ++m_indexedCount) {
+        m_index.insert(std::make_pair(m_items[m_indexedCount].hash(),
+                                      m_indexedCount));
+    }
+
+    auto range = m_index.equal_range(hash);
+    for(auto it = range.first; it != range.second; ++it) {
+        if(m_items[it->second] == item) {
+            return m_items.begin() + static_cast<long>(it->second);
+        }
     }
+    return m_items.end();
 }
 
 void VectorTile::remove(GIntBig id)
 {
+    // Item indices shift, so the index is rebuilt on next duplicates check
+    m_index.clear();
+    m_indexedCount = 0;
+
     auto it = m_items.begin();
     while(it != m_items.end()) {
         (*it).removeId(id);
@@ -297,28 +662,173 @@ void VectorTile::remove(GIntBig id)
     }
 }
 
-BufferPtr VectorTile::save()
+BufferPtr VectorTile::save(double step, bool compress) const
 {
+    // Quantized coordinates are relative to the minimum point of the tile
+    // snapped to the step grid, so the tile can be loaded and saved again
+    // without coordinates drift.
+    OGRRawPoint origin(0.0, 0.0);
+    if(step > 0.0) {
+        double minX = std::numeric_limits<double>::max();
+        double minY = std::numeric_limits<double>::max();
+        for(const auto &item : m_items) {
+            updateMinimum(minX, minY, item.m_points);
+            updateMinimum(minX, minY, item.m_centroids);
+        }
+        if(minX < std::numeric_limits<double>::max()) {
+            origin.x = std::floor(minX / step) * step;
+            origin.y = std::floor(minY / step) * step;
+        }
+    }
+
     BufferPtr buff(new Buffer);
-    buff->put(static_cast<GUInt32>(m_items.size()));
-    for(auto item : m_items) {
-        item.save(buff.get());
+    buff->put(TILE_MAGIC);
+    buff->put(static_cast<GByte>(TILE_FLAG_ID_RANGES | TILE_FLAG_LOCAL_COORDS));
+    size_t headerSize = buff->size();
+
+    buff->putVarint(m_items.size());
+    buff->put(origin.x);
+    buff->put(origin.y);
+    buff->put(step);
+    for(const auto &item : m_items) {
+        item.save(buff.get(), origin, step);
+    }
+
+    if(!compress) {
+        return buff;
+    }
+
+    size_t rawSize = static_cast<size_t>(buff->size()) - headerSize;
+    size_t outSize = 0;
+    void *out = CPLZLibDeflate(buff->data() + headerSize, rawSize, -1,
+                               nullptr, 0, &outSize);
+    if(nullptr == out) {
+        CPLDebug("ngstore", "Failed to compress tile. Store it uncompressed");
+        return buff;
+    }
+
+    BufferPtr compressed(new Buffer);
+    compressed->put(TILE_MAGIC);
+    compressed->put(static_cast<GByte>(TILE_FLAG_DEFLATE | TILE_FLAG_ID_RANGES |
+                                       TILE_FLAG_LOCAL_COORDS));
+    compressed->put(static_cast<GUInt32>(rawSize));
+    compressed->put(static_cast<GByte*>(out), outSize);
+    VSIFree(out);
+    return compressed;
+}
+
+/**
+ * @brief VectorTile::load Loads tile items from blob.
+ * @param buffer Blob data.
+ * @param origin Tile origin. Blobs with absolute coordinates are moved to it.
+ * @return True on success.
+ */
+bool VectorTile::load(Buffer &buffer, const OGRRawPoint &origin)
+{
+    size_t start = buffer.position();
+    if(buffer.getULong() != TILE_MAGIC) {
+        // Version 1 blob has no header.
+        buffer.seek(start);
+        return loadV1(buffer, origin);
+    }
+
+    GByte flags = buffer.getByte();
+    bool idRanges = (flags & TILE_FLAG_ID_RANGES) != 0;
+    OGRRawPoint shift;
+    if(!(flags & TILE_FLAG_LOCAL_COORDS)) {
+        shift = origin;
+    }
+    if(!(flags & TILE_FLAG_DEFLATE)) {
+        return loadV2(buffer, idRanges, shift);
+    }
+
+    size_t rawSize = buffer.getULong();
+    size_t pos = buffer.position();
+    if(rawSize > MAX_TILE_SIZE || pos > static_cast<size_t>(buffer.size())) {
+        return false;
+    }
+
+    GByte *raw = static_cast<GByte*>(CPLMalloc(rawSize));
+    size_t outSize = 0;
+    if(nullptr == CPLZLibInflate(buffer.data() + pos,
+                                 static_cast<size_t>(buffer.size()) - pos,
+                                 raw, rawSize, &outSize) ||
+       outSize != rawSize) {
+        CPLFree(raw);
+        CPLDebug("ngstore", "Failed to decompress tile");
+        return false;
     }
-    return buff;
+
+    Buffer rawBuffer(raw, static_cast<int>(rawSize));
+    return loadV2(rawBuffer, idRanges, shift);
 }
 
-bool VectorTile::load(Buffer &buffer)
+bool VectorTile::loadV1(Buffer &buffer, const OGRRawPoint &shift)
 {
+    size_t first = m_items.size();
     GUInt32 size = buffer.getULong();
     for(GUInt32 i = 0; i < size; ++i) {
         VectorTileItem item;
         item.load(buffer);
-        m_items.push_back(item);
+        m_items.push_back(std::move(item));
+    }
+    moveItems(shift, first);
+    m_valid = true;
+    return true;
+}
+
+bool VectorTile::loadV2(Buffer &buffer, bool idRanges, const OGRRawPoint &shift)
+{
+    GUIntBig size = buffer.getVarint();
+    if(size > static_cast<GUIntBig>(buffer.size())) {
+        return false;
+    }
+
+    OGRRawPoint origin;
+    origin.x = buffer.getDouble();
+    origin.y = buffer.getDouble();
+    double step = buffer.getDouble();
+
+    // Quantized coordinates are moved exactly with the blob origin
+    if(step > 0.0) {
+        origin.x -= shift.x;
+        origin.y -= shift.y;
+    }
+
+    size_t first = m_items.size();
+    m_items.reserve(m_items.size() + static_cast<size_t>(size));
+    for(GUIntBig i = 0; i < size; ++i) {
+        VectorTileItem item;
+        if(!item.load(buffer, idRanges, origin, step)) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+    }
+    if(!(step > 0.0)) {
+        moveItems(shift, first);
     }
     m_valid = true;
     return true;
 }
 
+void VectorTile::moveItems(const OGRRawPoint &shift, size_t first)
+{
+    if(isEqual(shift.x, 0.0) && isEqual(shift.y, 0.0)) {
+        return;
+    }
+
+    auto move = [&shift](std::vector<SimplePoint> &points) {
+        for(auto &point : points) {
+            point.x = static_cast<float>(static_cast<double>(point.x) - shift.x);
+            point.y = static_cast<float>(static_cast<double>(point.y) - shift.y);
+        }
+    };
+    for(size_t i = first; i < m_items.size(); ++i) {
+        move(m_items[i].m_points);
+        move(m_items[i].m_centroids);
+    }
+}
+
 bool VectorTile::empty() const
 {
     if(!m_items.empty()) {
@@ -331,6 +841,16 @@ bool VectorTile::empty() const
     return true;
 }
 
+size_t VectorTile::memorySize() const
+{
+    size_t size = sizeof(VectorTile);
+    for(const auto &item : m_items) {
+        size += item.memorySize();
+    }
+    size += m_index.size() * (sizeof(GUInt64) + sizeof(size_t));
+    return size;
+}
+
 //------------------------------------------------------------------------------
 // Envelope
 //------------------------------------------------------------------------------
@@ -608,16 +1128,31 @@ Normal ngsGetNormals(const SimplePoint &beg, const SimplePoint &end)
     return {normX, normY};
 }
 
+//------------------------------------------------------------------------------
+// GEOSContextHandlePtr
+//------------------------------------------------------------------------------
+GEOSContextHandlePtr GEOSContextHandlePtr::threadHandle()
+{
+    // One GEOS context per thread. It is freed on thread exit or when the
+    // last geometry which uses it is destroyed.
+    static thread_local GEOSContextHandlePtr handle;
+    return handle;
+}
+
 //------------------------------------------------------------------------------
 // GEOSGeometryWrap
 //------------------------------------------------------------------------------
 GEOSGeometryWrap::GEOSGeometryWrap(GEOSGeom geom, GEOSContextHandlePtr handle) :
     m_geom(geom),
-    m_geosHandle(handle)
+    m_geosHandle(handle),
+    m_simplifyType(SimplifyType::GRID)
 {
 }
 
-GEOSGeometryWrap::GEOSGeometryWrap(OGRGeometry *geom) : m_geom(nullptr)
+GEOSGeometryWrap::GEOSGeometryWrap(OGRGeometry *geom) :
+    m_geom(nullptr),
+    m_geosHandle(GEOSContextHandlePtr::threadHandle()),
+    m_simplifyType(SimplifyType::GRID)
 {
     if(nullptr != geom) {
         m_geom = geom->exportToGEOS(m_geosHandle.get());
@@ -650,7 +1185,173 @@ static OGRRawPoint generalize(double x, double y, double step)
     return out;
 }
 
-GEOSGeom GEOSGeometryWrap::generalizePoint(const GEOSGeom_t *geom, double step)
+static double segmentDistance2(const OGRRawPoint &pt, const OGRRawPoint &a,
+                               const OGRRawPoint &b)
+{
+    double x = a.x;
+    double y = a.y;
+    double dx = b.x - x;
+    double dy = b.y - y;
+    if(!isEqual(dx, 0.0) || !isEqual(dy, 0.0)) {
+        double t = ((pt.x - x) * dx + (pt.y - y) * dy) / (dx * dx + dy * dy);
+        if(t > 1.0) {
+            x = b.x;
+            y = b.y;
+        }
+        else if(t > 0.0) {
+            x += dx * t;
+            y += dy * t;
+        }
+    }
+    dx = pt.x - x;
+    dy = pt.y - y;
+    return dx * dx + dy * dy;
+}
+
+static double triangleArea(const OGRRawPoint &a, const OGRRawPoint &b,
+                           const OGRRawPoint &c)
+{
+    return std::fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) * 0.5;
+}
+
+/**
+ * @brief simplifyDouglasPeucker Marks points to keep using Douglas-Peucker
+ * algorithm. Uses explicit stack instead of recursion.
+ * @param points Line points. For ring the first and last points are equal.
+ * @param tolerance Maximum distance from simplified line.
+ * @param isRing The ring is split in farthest from start point, so it never
+ * collapses to a segment.
+ * @param keep Output flags, one per point.
+ */
+static void simplifyDouglasPeucker(const std::vector<OGRRawPoint> &points,
+                                   double tolerance, bool isRing,
+                                   std::vector<bool> &keep)
+{
+    size_t count = points.size();
+    keep.assign(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+
+    std::stack<std::pair<size_t, size_t>> ranges;
+    if(isRing && count > 3) {
+        size_t farthest = 1;
+        double maxDist = 0.0;
+        for(size_t i = 1; i < count - 1; ++i) {
+            double dx = points[i].x - points[0].x;
+            double dy = points[i].y - points[0].y;
+            double dist = dx * dx + dy * dy;
+            if(dist > maxDist) {
+                maxDist = dist;
+                farthest = i;
+            }
+        }
+        keep[farthest] = true;
+        ranges.push(std::make_pair(0, farthest));
+        ranges.push(std::make_pair(farthest, count - 1));
+    }
+    else {
+        ranges.push(std::make_pair(0, count - 1));
+    }
+
+    double tolerance2 = tolerance * tolerance;
+    while(!ranges.empty()) {
+        size_t first = ranges.top().first;
+        size_t last = ranges.top().second;
+        ranges.pop();
+
+        double maxDist = tolerance2;
+        size_t index = 0;
+        for(size_t i = first + 1; i < last; ++i) {
+            double dist = segmentDistance2(points[i], points[first],
+                                           points[last]);
+            if(dist > maxDist) {
+                maxDist = dist;
+                index = i;
+            }
+        }
+
+        if(index > 0) {
+            keep[index] = true;
+            ranges.push(std::make_pair(first, index));
+            ranges.push(std::make_pair(index, last));
+        }
+    }
+}
+
+/**
+ * @brief simplifyVisvalingam Marks points to keep using Visvalingam-Whyatt
+ * algorithm. Points with the smallest effective area are removed first with
+ * priority queue, outdated queue items are skipped by version.
+ * @param points Line points. For ring the first and last points are equal.
+ * @param minArea Points with effective area less than this are removed.
+ * @param minCount Minimum points count to keep.
+ * @param keep Output flags, one per point.
+ */
+static void simplifyVisvalingam(const std::vector<OGRRawPoint> &points,
+                                double minArea, size_t minCount,
+                                std::vector<bool> &keep)
+{
+    struct AreaItem {
+        double area;
+        size_t index;
+        unsigned int version;
+        bool operator<(const AreaItem &other) const {
+            return area > other.area;
+        }
+    };
+
+    size_t count = points.size();
+    keep.assign(count, true);
+    if(count <= minCount || count < 3) {
+        return;
+    }
+
+    std::vector<size_t> prev(count), next(count);
+    std::vector<double> areas(count, 0.0);
+    std::vector<unsigned int> versions(count, 0);
+    std::priority_queue<AreaItem> queue;
+    for(size_t i = 1; i < count - 1; ++i) {
+        prev[i] = i - 1;
+        next[i] = i + 1;
+        areas[i] = triangleArea(points[i - 1], points[i], points[i + 1]);
+        queue.push({areas[i], i, 0});
+    }
+
+    size_t left = count;
+    while(!queue.empty() && left > minCount) {
+        AreaItem item = queue.top();
+        queue.pop();
+        if(!keep[item.index] || item.version != versions[item.index]) {
+            continue;
+        }
+        if(item.area >= minArea) {
+            break;
+        }
+
+        keep[item.index] = false;
+        left--;
+
+        size_t p = prev[item.index];
+        size_t n = next[item.index];
+        next[p] = n;
+        prev[n] = p;
+
+        // Neighbour area is never less than removed one, so points are
+        // removed in effective area order.
+        if(p > 0) {
+            areas[p] = std::max(triangleArea(points[prev[p]], points[p],
+                                             points[n]), item.area);
+            queue.push({areas[p], p, ++versions[p]});
+        }
+        if(n < count - 1) {
+            areas[n] = std::max(triangleArea(points[p], points[n],
+                                             points[next[n]]), item.area);
+            queue.push({areas[n], n, ++versions[n]});
+        }
+    }
+}
+
+GEOSGeom GEOSGeometryWrap::generalizePoint(const GEOSGeom_t *geom, double step)
 {
     double x, y;
     const GEOSCoordSequence* cs = GEOSGeom_getCoordSeq_r(m_geosHandle.get(), geom);
@@ -721,30 +1422,65 @@ GEOSGeom GEOSGeometryWrap::generalizeLine(const GEOSGeom_t *geom, double step,
     OGRRawPoint prevGpoint(BIG_VALUE, BIG_VALUE);
     double x, y;
     std::vector<OGRRawPoint> parts;
-    struct OGRRawPointIs {
-        OGRRawPointIs( OGRRawPoint s ) : toFind(s) { }
-        bool operator() (const OGRRawPoint &n) {
-            return isEqual(n.x, toFind.x) && isEqual(n.y, toFind.y);
+    if(m_simplifyType == SimplifyType::GRID) {
+        std::set<std::pair<long, long>> ringCells;
+        for(unsigned int i = 0; i < count; ++i) {
+            GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
+            GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
+            OGRRawPoint gpoint = generalize(x, y, step);
+
+            if(isRing && !ringCells.insert(
+                        std::make_pair(static_cast<long>(x / step),
+                                       static_cast<long>(y / step))).second) {
+                continue;
+            }
+
+            if(isEqual(prevGpoint.x, gpoint.x) && isEqual(prevGpoint.y, gpoint.y)) {
+                continue;
+            }
+
+            parts.push_back(gpoint);
+            prevGpoint = gpoint;
+        }
+    }
+    else {
+        std::vector<OGRRawPoint> points;
+        points.reserve(count);
+        for(unsigned int i = 0; i < count; ++i) {
+            GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
+            GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
+            if(isEqual(prevGpoint.x, x) && isEqual(prevGpoint.y, y)) {
+                continue;
+            }
+            prevGpoint = OGRRawPoint(x, y);
+            points.push_back(prevGpoint);
         }
-        OGRRawPoint toFind;
-    };
 
-    for(unsigned int i = 0; i < count; ++i) {
-        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
-        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
-        OGRRawPoint gpoint = generalize(x, y, step);
+        if(points.size() < 2) {
+            return nullptr;
+        }
 
-        if(isRing && std::find_if(parts.begin(), parts.end(),
-                                  OGRRawPointIs(gpoint)) != parts.end()) {
-            continue;
+        std::vector<bool> keep;
+        if(m_simplifyType == SimplifyType::DOUGLAS_PEUCKER) {
+            simplifyDouglasPeucker(points, step, isRing, keep);
+        }
+        else {
+            simplifyVisvalingam(points, step * step * 0.5, isRing ? 4 : 2,
+                                keep);
         }
 
-        if(isEqual(prevGpoint.x, gpoint.x) && isEqual(prevGpoint.y, gpoint.y)) {
-            continue;
+        for(size_t i = 0; i < points.size(); ++i) {
+            if(keep[i]) {
+                parts.push_back(points[i]);
+            }
         }
 
-        parts.push_back(gpoint);
-        prevGpoint = gpoint;
+        // Ring is closed below
+        if(isRing && parts.size() > 1 &&
+                isEqual(parts.front().x, parts.back().x) &&
+                isEqual(parts.front().y, parts.back().y)) {
+            parts.pop_back();
+        }
     }
 
     if(parts.size() < 2) {
@@ -835,6 +1571,15 @@ GEOSGeom GEOSGeometryWrap::generalizePolygon(const GEOSGeom_t *geom, double step
         return env;
     }
 
+    if(m_simplifyType != SimplifyType::GRID) {
+        GEOSGeom simple = simplifyPolygonRings(geom, step);
+        if(nullptr == simple) {
+            return env;
+        }
+        GEOSGeom_destroy_r(m_geosHandle.get(), env);
+        return simple;
+    }
+
     GEOSGeom simple = GEOSSimplify_r(m_geosHandle.get(), geom, step * .25);
     if(nullptr == simple || GEOSisEmpty_r(m_geosHandle.get(), simple) == 1) {
         CPLDebug("ngstore", "Simplify generalize polygon failed");
@@ -877,6 +1622,46 @@ GEOSGeom GEOSGeometryWrap::generalizePolygon(const GEOSGeom_t *geom, double step
     */
 }
 
+GEOSGeom GEOSGeometryWrap::simplifyPolygonRings(const GEOSGeom_t *geom,
+                                                double step)
+{
+    const GEOSGeometry *exteriorRing = GEOSGetExteriorRing_r(m_geosHandle.get(),
+                                                             geom);
+    GEOSGeom newRing = generalizeLine(exteriorRing, step, true);
+    if(nullptr == newRing) {
+        return nullptr;
+    }
+
+    int count = GEOSGetNumInteriorRings_r(m_geosHandle.get(), geom);
+    std::vector<GEOSGeom> interiorRings;
+    for(int i = 0; i < count; ++i) {
+        const GEOSGeometry *interiorRing = GEOSGetInteriorRingN_r(
+                    m_geosHandle.get(), geom, i);
+        GEOSGeom newInteriorRing = generalizeLine(interiorRing, step, true);
+        if(nullptr != newInteriorRing) {
+            interiorRings.push_back(newInteriorRing);
+        }
+    }
+
+    GEOSGeom p = GEOSGeom_createPolygon_r(m_geosHandle.get(), newRing,
+                                          interiorRings.data(),
+                                          static_cast<unsigned int>(interiorRings.size()));
+    if(nullptr != p && GEOSisValid_r(m_geosHandle.get(), p) == 1) {
+        return p;
+    }
+    GEOSGeom_destroy_r(m_geosHandle.get(), p);
+
+    // Rings simplified independently may cross each other.
+    CPLDebug("ngstore", "Simplified polygon is not valid, preserve topology");
+    GEOSGeom simple = GEOSTopologyPreserveSimplify_r(m_geosHandle.get(), geom,
+                                                     step);
+    if(nullptr != simple && GEOSisEmpty_r(m_geosHandle.get(), simple) == 1) {
+        GEOSGeom_destroy_r(m_geosHandle.get(), simple);
+        return nullptr;
+    }
+    return simple;
+}
+
 GEOSGeom GEOSGeometryWrap::generalizeMultiPolygon(const GEOSGeom_t *geom,
                                                   double step)
 {
@@ -945,6 +1730,12 @@ void GEOSGeometryWrap::setCentroid(int type)
     }
 }
 
+// Tile point keeps float precision as it is relative to the tile origin
+static SimplePoint tilePoint(double x, double y, const OGRRawPoint &origin)
+{
+    return { static_cast<float>(x - origin.x), static_cast<float>(y - origin.y) };
+}
+
 void GEOSGeometryWrap::fillPointTile(GIntBig fid, const GEOSGeom_t *geom,
                                      VectorTileItemArray &vitemArray)
 {
@@ -954,7 +1745,7 @@ void GEOSGeometryWrap::fillPointTile(GIntBig fid, const GEOSGeom_t *geom,
     double x(0.0), y(0.0);
     GEOSGeomGetX_r(m_geosHandle.get(), geom, &x);
     GEOSGeomGetY_r(m_geosHandle.get(), geom, &y);
-    SimplePoint pt = { static_cast<float>(x), static_cast<float>(y) };
+    SimplePoint pt = tilePoint(x, y, m_tileOrigin);
 
     vitem.addPoint(pt);
 
@@ -980,7 +1771,7 @@ void GEOSGeometryWrap::fillMultiPointTile(GIntBig fid, const GEOSGeom_t *geom,
         double x(0.0), y(0.0);
         GEOSGeomGetX_r(m_geosHandle.get(), g, &x);
         GEOSGeomGetY_r(m_geosHandle.get(), g, &y);
-        SimplePoint pt = { static_cast<float>(x), static_cast<float>(y) };
+        SimplePoint pt = tilePoint(x, y, m_tileOrigin);
         vitem.addPoint(pt);
     }
 
@@ -1005,7 +1796,7 @@ void GEOSGeometryWrap::fillLineTile(GIntBig fid, const GEOSGeom_t *geom,
     for(unsigned int i = 0; i < count; ++i) {
         GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
         GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
-        SimplePoint pt = { static_cast<float>(x), static_cast<float>(y) };
+        SimplePoint pt = tilePoint(x, y, m_tileOrigin);
         vitem.addPoint(pt);
     }
 
@@ -1079,41 +1870,89 @@ OGRRawPoint findPointByIndex(N index, const MBPolygon &poly)
 void GEOSGeometryWrap::fillPolygonTile(GIntBig fid, const GEOSGeom_t *geom,
                                        VectorTileItemArray& vitemArray)
 {
+    int holeCount = GEOSGetNumInteriorRings_r(m_geosHandle.get(), geom);
+    std::vector<std::vector<OGRRawPoint>> rings(
+                static_cast<size_t>(holeCount + 1));
+    for(int i = -1; i < holeCount; ++i) {
+        const GEOSGeometry *ring = i < 0 ?
+                    GEOSGetExteriorRing_r(m_geosHandle.get(), geom) :
+                    GEOSGetInteriorRingN_r(m_geosHandle.get(), geom, i);
+        const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r(m_geosHandle.get(),
+                                                             ring);
+        unsigned int count = 0;
+        GEOSCoordSeq_getSize_r(m_geosHandle.get(), cs, &count);
+
+        auto &points = rings[static_cast<size_t>(i + 1)];
+        points.reserve(count);
+        double x(0.0), y(0.0);
+        for(unsigned int j = 0; j < count; ++j) {
+            GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, j, &x);
+            GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, j, &y);
+            points.push_back(OGRRawPoint(x, y));
+        }
+    }
+    fillPolygonRings(fid, rings, m_tileOrigin, vitemArray);
+}
+
+static OGRRawPoint ringCentroid(const std::vector<OGRRawPoint> &ring)
+{
+    double area = 0.0, x = 0.0, y = 0.0;
+    for(size_t i = 1; i < ring.size(); ++i) {
+        const OGRRawPoint &a = ring[i - 1];
+        const OGRRawPoint &b = ring[i];
+        double cross = a.x * b.y - b.x * a.y;
+        area += cross;
+        x += (a.x + b.x) * cross;
+        y += (a.y + b.y) * cross;
+    }
+    if(isEqual(area, 0.0)) {
+        x = y = 0.0;
+        for(const auto &pt : ring) {
+            x += pt.x;
+            y += pt.y;
+        }
+        return OGRRawPoint(x / ring.size(), y / ring.size());
+    }
+    return OGRRawPoint(x / (3.0 * area), y / (3.0 * area));
+}
+
+/**
+ * @brief GEOSGeometryWrap::fillPolygonRings Triangulates polygon and adds it
+ * to tile items.
+ * @param fid Feature identifier.
+ * @param rings Closed rings, the first one is exterior.
+ * @param origin Tile origin.
+ * @param vitemArray Output tile items.
+ * @param degenerateFallback Add small triangle at the centroid of polygon
+ * which failed to triangulate. Off for clipped rings, where such polygon has
+ * nothing to draw in the tile.
+ */
+void GEOSGeometryWrap::fillPolygonRings(GIntBig fid,
+        const std::vector<std::vector<OGRRawPoint>> &rings,
+        const OGRRawPoint &origin, VectorTileItemArray &vitemArray,
+        bool degenerateFallback)
+{
+    if(rings.empty() || rings[0].empty()) {
+        return;
+    }
+
     VectorTileItem vitem;
     vitem.addId(fid);
     unsigned short index = 0;
     double x(0.0), y(0.0);
 
-    int holeCount = GEOSGetNumInteriorRings_r(m_geosHandle.get(), geom);
-
-    const GEOSGeometry *exteriorRing = GEOSGetExteriorRing_r(m_geosHandle.get(),
-                                                             geom);
-    const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r(m_geosHandle.get(),
-                                                         exteriorRing);
-    unsigned int count = 0;
-    GEOSCoordSeq_getSize_r(m_geosHandle.get(), cs, &count);
+    size_t holeCount = rings.size() - 1;
+    const std::vector<OGRRawPoint> &exteriorRing = rings[0];
+    size_t count = exteriorRing.size();
 
     if(count == 4 && holeCount == 0) {
-        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, 0, &x);
-        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, 0, &y);
-        SimplePoint pt1 = { static_cast<float>(x), static_cast<float>(y) };
-        vitem.addPoint(pt1);
-        vitem.addBorderIndex(0, index);
-        vitem.addIndex(index++);
-
-        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, 1, &x);
-        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, 1, &y);
-        SimplePoint pt2 = { static_cast<float>(x), static_cast<float>(y) };
-        vitem.addPoint(pt2);
-        vitem.addBorderIndex(0, index);
-        vitem.addIndex(index++);
-
-        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, 2, &x);
-        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, 2, &y);
-        SimplePoint pt3 = { static_cast<float>(x), static_cast<float>(y) };
-        vitem.addPoint(pt3);
-        vitem.addBorderIndex(0, index);
-        vitem.addIndex(index++);
+        for(size_t i = 0; i < 3; ++i) {
+            SimplePoint pt = tilePoint(exteriorRing[i].x, exteriorRing[i].y,
+                                       origin);
+            vitem.addPoint(pt);
+            vitem.addBorderIndex(0, index);
+            vitem.addIndex(index++);
+        }
 
         vitem.addBorderIndex(0, 0); // Close ring
 
@@ -1124,38 +1963,15 @@ void GEOSGeometryWrap::fillPolygonTile(GIntBig fid, const GEOSGeom_t *geom,
 
     EDGES edges;
     MBPolygon polygon;
-    std::vector<MBPoint> mbExteriorRing;
-    for(unsigned int i = 0; i < count; ++i) { // Without last point
-        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
-        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
-
-        edges[0].push_back({OGRRawPoint(x, y), MAX_EDGE_INDEX});
-
-        MBPoint mbpt{ { x, y } };
-        mbExteriorRing.emplace_back(mbpt);
-    }
-
-    polygon.emplace_back(mbExteriorRing);
+    for(size_t i = 0; i < rings.size(); ++i) {
+        std::vector<MBPoint> mbRing;
+        for(const auto &pt : rings[i]) {
+            edges[static_cast<int>(i)].push_back({pt, MAX_EDGE_INDEX});
 
-    for(int i = 0; i < holeCount; ++i) {
-        const GEOSGeometry *interiorRing = GEOSGetInteriorRingN_r(
-                    m_geosHandle.get(), geom, i);
-        const GEOSCoordSequence* hcs = GEOSGeom_getCoordSeq_r(m_geosHandle.get(),
-                                                             interiorRing);
-        unsigned int hcount = 0;
-        GEOSCoordSeq_getSize_r(m_geosHandle.get(), hcs, &hcount);
-
-        std::vector<MBPoint> mbInteriorRing;
-        for(unsigned int j = 0; j < hcount; ++j) {
-            GEOSCoordSeq_getX_r(m_geosHandle.get(), hcs, j, &x);
-            GEOSCoordSeq_getY_r(m_geosHandle.get(), hcs, j, &y);
-
-            edges[i + 1].push_back({OGRRawPoint(x, y), MAX_EDGE_INDEX});
-
-            MBPoint mbpt{ { x, y } };
-            mbInteriorRing.emplace_back(mbpt);
+            MBPoint mbpt{ { pt.x, pt.y } };
+            mbRing.emplace_back(mbpt);
         }
-        polygon.emplace_back(mbInteriorRing);
+        polygon.emplace_back(mbRing);
     }
 
     // Run tessellation
@@ -1163,23 +1979,26 @@ void GEOSGeometryWrap::fillPolygonTile(GIntBig fid, const GEOSGeom_t *geom,
     // Three subsequent indices form a triangle.
     std::vector<N> indices = mapbox::earcut<N>(polygon);
     if(indices.empty()) {
-        GEOSGeom g = GEOSGetCentroid_r(m_geosHandle.get(), geom);
-        GEOSGeomGetX_r(m_geosHandle.get(), g, &x);
-        GEOSGeomGetY_r(m_geosHandle.get(), g, &y);
-        GEOSGeom_destroy_r(m_geosHandle.get(), g);
+        if(!degenerateFallback) {
+            return;
+        }
+
+        OGRRawPoint center = ringCentroid(exteriorRing);
+        x = center.x;
+        y = center.y;
 
         index = 0;
-        SimplePoint pt1 = { static_cast<float>(x - 0.5), static_cast<float>(y - 0.5) };
+        SimplePoint pt1 = tilePoint(x - 0.5, y - 0.5, origin);
         vitem.addPoint(pt1);
         vitem.addBorderIndex(0, index);
         vitem.addIndex(index++);
 
-        SimplePoint pt2 = { static_cast<float>(x + 0.5), static_cast<float>(y - 0.5) };
+        SimplePoint pt2 = tilePoint(x + 0.5, y - 0.5, origin);
         vitem.addPoint(pt2);
         vitem.addBorderIndex(0, index);
         vitem.addIndex(index++);
 
-        SimplePoint pt3 = { static_cast<float>(x + 0.5), static_cast<float>(y + 0.5) };
+        SimplePoint pt3 = tilePoint(x + 0.5, y + 0.5, origin);
         vitem.addPoint(pt3);
         vitem.addBorderIndex(0, index);
         vitem.addIndex(index++);
@@ -1203,8 +2022,7 @@ void GEOSGeometryWrap::fillPolygonTile(GIntBig fid, const GEOSGeom_t *geom,
             tinIndex = 0;
 
             for(unsigned char j = 0; j < 3; ++j) {
-                SimplePoint pt = { static_cast<float>(tin[j].x),
-                                   static_cast<float>(tin[j].y) };
+                SimplePoint pt = tilePoint(tin[j].x, tin[j].y, origin);
                 vitem.addPoint(pt);
                 // Check each vertex belongs to exterior or interior ring
                 setEdgeIndex(vertexIndex, tin[j].x, tin[j].y, edges);
@@ -1470,12 +2288,16 @@ void GEOSGeometryWrap::fillCollectionTile(GIntBig fid, const GEOSGeom_t *geom,
     }
 }
 
-void GEOSGeometryWrap::simplify(double step)
+void GEOSGeometryWrap::simplify(double step, SimplifyType simplifyType)
 {
     if(isEqual(step, 0.0) || nullptr == m_geom) {
         return;
     }
 
+    m_flat = FlatGeometry();
+
+    m_simplifyType = simplifyType;
+
     GEOSGeom g;
     switch(type()) {
     case GEOS_POINT:
@@ -1542,12 +2364,15 @@ void GEOSGeometryWrap::simplify(double step)
     }
 }
 
-void GEOSGeometryWrap::fillTile(GIntBig fid, VectorTileItemArray &vitemArray)
+void GEOSGeometryWrap::fillTile(GIntBig fid, VectorTileItemArray &vitemArray,
+                                const OGRRawPoint &origin)
 {
     if(nullptr == m_geom || GEOSisEmpty_r(m_geosHandle.get(), m_geom) == 1) {
         return;
     }
 
+    m_tileOrigin = origin;
+
     switch(type()) {
     case GEOS_POINT:
         fillPointTile(fid, m_geom, vitemArray);
@@ -1578,6 +2403,390 @@ void GEOSGeometryWrap::fillTile(GIntBig fid, VectorTileItemArray &vitemArray)
     }
 }
 
+//------------------------------------------------------------------------------
+// Rectangle clipping of flat coordinates
+//------------------------------------------------------------------------------
+
+enum OutCode : unsigned char {
+    OUT_INSIDE = 0,
+    OUT_LEFT = 1,
+    OUT_RIGHT = 2,
+    OUT_BOTTOM = 4,
+    OUT_TOP = 8
+};
+
+static unsigned char outCode(const OGRRawPoint &pt, const Envelope &env)
+{
+    unsigned char code = OUT_INSIDE;
+    if(pt.x < env.minX()) {
+        code |= OUT_LEFT;
+    }
+    else if(pt.x > env.maxX()) {
+        code |= OUT_RIGHT;
+    }
+    if(pt.y < env.minY()) {
+        code |= OUT_BOTTOM;
+    }
+    else if(pt.y > env.maxY()) {
+        code |= OUT_TOP;
+    }
+    return code;
+}
+
+/**
+ * Cohen-Sutherland segment clipping.
+ * @return False if segment is outside of envelope.
+ */
+static bool clipSegment(OGRRawPoint &a, OGRRawPoint &b, const Envelope &env)
+{
+    unsigned char codeA = outCode(a, env);
+    unsigned char codeB = outCode(b, env);
+    while(true) {
+        if(!(codeA | codeB)) {
+            return true;
+        }
+        if(codeA & codeB) {
+            return false;
+        }
+
+        unsigned char code = codeA ? codeA : codeB;
+        OGRRawPoint pt;
+        if(code & OUT_TOP) {
+            pt.x = a.x + (b.x - a.x) * (env.maxY() - a.y) / (b.y - a.y);
+            pt.y = env.maxY();
+        }
+        else if(code & OUT_BOTTOM) {
+            pt.x = a.x + (b.x - a.x) * (env.minY() - a.y) / (b.y - a.y);
+            pt.y = env.minY();
+        }
+        else if(code & OUT_RIGHT) {
+            pt.y = a.y + (b.y - a.y) * (env.maxX() - a.x) / (b.x - a.x);
+            pt.x = env.maxX();
+        }
+        else {
+            pt.y = a.y + (b.y - a.y) * (env.minX() - a.x) / (b.x - a.x);
+            pt.x = env.minX();
+        }
+
+        if(code == codeA) {
+            a = pt;
+            codeA = outCode(a, env);
+        }
+        else {
+            b = pt;
+            codeB = outCode(b, env);
+        }
+    }
+}
+
+static void clipLine(const std::vector<OGRRawPoint> &line, const Envelope &env,
+                     std::vector<std::vector<OGRRawPoint>> &parts)
+{
+    std::vector<OGRRawPoint> part;
+    for(size_t i = 1; i < line.size(); ++i) {
+        OGRRawPoint a = line[i - 1];
+        OGRRawPoint b = line[i];
+        if(!clipSegment(a, b, env)) {
+            continue;
+        }
+
+        if(part.empty() || !isEqual(part.back().x, a.x) ||
+                !isEqual(part.back().y, a.y)) {
+            if(part.size() > 1) {
+                parts.push_back(part);
+            }
+            part.clear();
+            part.push_back(a);
+        }
+        part.push_back(b);
+
+        // Line leaves envelope
+        if(!isEqual(b.x, line[i].x) || !isEqual(b.y, line[i].y)) {
+            if(part.size() > 1) {
+                parts.push_back(part);
+            }
+            part.clear();
+        }
+    }
+    if(part.size() > 1) {
+        parts.push_back(part);
+    }
+}
+
+/**
+ * Sutherland-Hodgman ring clipping by one envelope side.
+ * @param side 0 - left, 1 - right, 2 - bottom, 3 - top.
+ */
+static void clipRingSide(const std::vector<OGRRawPoint> &ring, int side,
+                         const Envelope &env, std::vector<OGRRawPoint> &out)
+{
+    auto inside = [&](const OGRRawPoint &pt) {
+        switch(side) {
+        case 0: return pt.x >= env.minX();
+        case 1: return pt.x <= env.maxX();
+        case 2: return pt.y >= env.minY();
+        default: return pt.y <= env.maxY();
+        }
+    };
+    auto intersect = [&](const OGRRawPoint &a, const OGRRawPoint &b) {
+        double value;
+        switch(side) {
+        case 0:
+        case 1:
+            value = side == 0 ? env.minX() : env.maxX();
+            return OGRRawPoint(value, a.y + (b.y - a.y) * (value - a.x) /
+                               (b.x - a.x));
+        default:
+            value = side == 2 ? env.minY() : env.maxY();
+            return OGRRawPoint(a.x + (b.x - a.x) * (value - a.y) / (b.y - a.y),
+                               value);
+        }
+    };
+
+    out.clear();
+    if(ring.empty()) {
+        return;
+    }
+    OGRRawPoint prev = ring.back();
+    bool prevInside = inside(prev);
+    for(const auto &pt : ring) {
+        bool ptInside = inside(pt);
+        if(ptInside != prevInside) {
+            out.push_back(intersect(prev, pt));
+        }
+        if(ptInside) {
+            out.push_back(pt);
+        }
+        prev = pt;
+        prevInside = ptInside;
+    }
+}
+
+static double ringArea(const std::vector<OGRRawPoint> &ring)
+{
+    double area = 0.0;
+    for(size_t i = 0; i < ring.size(); ++i) {
+        const OGRRawPoint &a = ring[i];
+        const OGRRawPoint &b = ring[(i + 1) % ring.size()];
+        area += a.x * b.y - b.x * a.y;
+    }
+    return std::fabs(area) * 0.5;
+}
+
+/**
+ * Clips closed ring. Result ring is closed, without repeated points.
+ * @return False if nothing left from ring.
+ */
+static bool clipRing(const std::vector<OGRRawPoint> &ring, const Envelope &env,
+                     std::vector<OGRRawPoint> &out)
+{
+    // Work on open ring
+    std::vector<OGRRawPoint> current(ring.begin(), ring.end());
+    if(current.size() > 1 && isEqual(current.front().x, current.back().x) &&
+            isEqual(current.front().y, current.back().y)) {
+        current.pop_back();
+    }
+
+    std::vector<OGRRawPoint> next;
+    for(int side = 0; side < 4 && !current.empty(); ++side) {
+        clipRingSide(current, side, env, next);
+        current.swap(next);
+    }
+
+    // Ring fix-up: remove repeated points, drop degenerate rings
+    out.clear();
+    for(const auto &pt : current) {
+        if(out.empty() || !isEqual(out.back().x, pt.x) ||
+                !isEqual(out.back().y, pt.y)) {
+            out.push_back(pt);
+        }
+    }
+    while(out.size() > 1 && isEqual(out.front().x, out.back().x) &&
+          isEqual(out.front().y, out.back().y)) {
+        out.pop_back();
+    }
+    if(out.size() < 3) {
+        out.clear();
+        return false;
+    }
+
+    if(isEqual(ringArea(out), 0.0)) {
+        out.clear();
+        return false;
+    }
+
+    out.push_back(out.front());
+    return true;
+}
+
+std::vector<OGRRawPoint> GEOSGeometryWrap::flatPoints(const GEOSGeom_t *geom) const
+{
+    std::vector<OGRRawPoint> out;
+    const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r(m_geosHandle.get(),
+                                                         geom);
+    unsigned int count = 0;
+    if(nullptr == cs || !GEOSCoordSeq_getSize_r(m_geosHandle.get(), cs, &count)) {
+        return out;
+    }
+
+    out.reserve(count);
+    double x(0.0), y(0.0);
+    for(unsigned int i = 0; i < count; ++i) {
+        GEOSCoordSeq_getX_r(m_geosHandle.get(), cs, i, &x);
+        GEOSCoordSeq_getY_r(m_geosHandle.get(), cs, i, &y);
+        out.push_back(OGRRawPoint(x, y));
+    }
+    return out;
+}
+
+bool GEOSGeometryWrap::addFlatGeometry(const GEOSGeom_t *geom)
+{
+    if(GEOSisEmpty_r(m_geosHandle.get(), geom) == 1) {
+        return true;
+    }
+
+    switch(GEOSGeomTypeId_r(m_geosHandle.get(), geom)) {
+    case GEOS_POINT:
+    {
+        double x(0.0), y(0.0);
+        GEOSGeomGetX_r(m_geosHandle.get(), geom, &x);
+        GEOSGeomGetY_r(m_geosHandle.get(), geom, &y);
+        m_flat.points.push_back(OGRRawPoint(x, y));
+        return true;
+    }
+    case GEOS_LINESTRING:
+        m_flat.lines.push_back(flatPoints(geom));
+        return true;
+    case GEOS_POLYGON:
+    {
+        int holeCount = GEOSGetNumInteriorRings_r(m_geosHandle.get(), geom);
+        std::vector<std::vector<OGRRawPoint>> rings;
+        rings.push_back(flatPoints(GEOSGetExteriorRing_r(m_geosHandle.get(),
+                                                         geom)));
+        for(int i = 0; i < holeCount; ++i) {
+            rings.push_back(flatPoints(GEOSGetInteriorRingN_r(
+                                           m_geosHandle.get(), geom, i)));
+        }
+        m_flat.polygons.push_back(rings);
+        return true;
+    }
+    case GEOS_MULTIPOINT:
+    case GEOS_MULTILINESTRING:
+    case GEOS_MULTIPOLYGON:
+    case GEOS_GEOMETRYCOLLECTION:
+    {
+        int count = GEOSGetNumGeometries_r(m_geosHandle.get(), geom);
+        for(int i = 0; i < count; ++i) {
+            if(!addFlatGeometry(GEOSGetGeometryN_r(m_geosHandle.get(), geom,
+                                                   i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void GEOSGeometryWrap::buildFlatGeometry()
+{
+    m_flat = FlatGeometry();
+    m_flat.ready = true;
+    if(nullptr == m_geom) {
+        return;
+    }
+
+    // Invalid polygons are clipped by GEOS, i.e. self intersected rings
+    if(!addFlatGeometry(m_geom) || (!m_flat.polygons.empty() &&
+            GEOSisValid_r(m_geosHandle.get(), m_geom) != 1)) {
+        m_flat = FlatGeometry();
+        m_flat.ready = true;
+        m_flat.useGeos = true;
+    }
+}
+
+/**
+ * @brief GEOSGeometryWrap::fillClippedTile Clips geometry by envelope and adds
+ * the result to tile items. Coordinates are copied once after each simplify,
+ * lines are clipped with Cohen-Sutherland and polygon rings with
+ * Sutherland-Hodgman algorithm. Invalid geometry is clipped by GEOS.
+ * @param fid Feature identifier.
+ * @param env Clip envelope.
+ * @param vitemArray Output tile items.
+ * @param origin Tile origin, items coordinates are relative to it.
+ */
+void GEOSGeometryWrap::fillClippedTile(GIntBig fid, const Envelope &env,
+                                       VectorTileItemArray &vitemArray,
+                                       const OGRRawPoint &origin)
+{
+    if(!m_flat.ready) {
+        buildFlatGeometry();
+    }
+
+    if(m_flat.useGeos) {
+        GEOSGeometryPtr clipGeom = clip(env);
+        clipGeom->fillTile(fid, vitemArray, origin);
+        return;
+    }
+
+    if(!m_flat.points.empty()) {
+        VectorTileItem vitem;
+        vitem.addId(fid);
+        for(const auto &pt : m_flat.points) {
+            if(outCode(pt, env) == OUT_INSIDE) {
+                vitem.addPoint(tilePoint(pt.x, pt.y, origin));
+            }
+        }
+        if(vitem.pointCount() > 0) {
+            vitem.setValid(true);
+            vitemArray.push_back(vitem);
+        }
+    }
+
+    std::vector<std::vector<OGRRawPoint>> parts;
+    for(const auto &line : m_flat.lines) {
+        clipLine(line, env, parts);
+    }
+    for(const auto &part : parts) {
+        VectorTileItem vitem;
+        vitem.addId(fid);
+        for(const auto &pt : part) {
+            vitem.addPoint(tilePoint(pt.x, pt.y, origin));
+        }
+        vitem.setValid(true);
+        vitemArray.push_back(vitem);
+    }
+
+    for(const auto &polygon : m_flat.polygons) {
+        std::vector<std::vector<OGRRawPoint>> rings;
+        std::vector<OGRRawPoint> ring;
+        for(size_t i = 0; i < polygon.size(); ++i) {
+            if(clipRing(polygon[i], env, ring)) {
+                rings.push_back(ring);
+            }
+            else if(i == 0) {
+                break;
+            }
+        }
+        if(rings.empty()) {
+            continue;
+        }
+
+        // Holes of valid polygon do not overlap, so holes covering the whole
+        // clipped exterior mean the tile lies inside a hole.
+        double holesArea = 0.0;
+        for(size_t i = 1; i < rings.size(); ++i) {
+            holesArea += ringArea(rings[i]);
+        }
+        if(rings.size() > 1 &&
+                holesArea >= ringArea(rings[0]) * (1.0 - CLIP_AREA_EPSILON)) {
+            continue;
+        }
+        fillPolygonRings(fid, rings, origin, vitemArray, false);
+    }
+}
+
 double GEOSGeometryWrap::distance(double x, double y) const
 {
     GEOSCoordSequence *seq = GEOSCoordSeq_create_r(m_geosHandle.get(), 1, 2);
@@ -1601,6 +2810,187 @@ bool GEOSGeometryWrap::intersects(double x, double y) const
     return result;
 }
 
+static GEOSCoordSequence *createCoordSeq(GEOSContextHandle_t handle,
+                                         const std::vector<SimplePoint> &points,
+                                         const std::vector<unsigned short> &indices,
+                                         const OGRRawPoint &origin)
+{
+    GEOSCoordSequence *seq = GEOSCoordSeq_create_r(
+                handle, static_cast<unsigned int>(indices.size()), 2);
+    unsigned int i = 0;
+    for(auto index : indices) {
+        if(index >= points.size()) {
+            GEOSCoordSeq_destroy_r(handle, seq);
+            return nullptr;
+        }
+        GEOSCoordSeq_setX_r(handle, seq, i,
+                            origin.x + static_cast<double>(points[index].x));
+        GEOSCoordSeq_setY_r(handle, seq, i,
+                            origin.y + static_cast<double>(points[index].y));
+        i++;
+    }
+    return seq;
+}
+
+static GEOSGeom createRing(GEOSContextHandle_t handle,
+                           const std::vector<SimplePoint> &points,
+                           const std::vector<unsigned short> &indices,
+                           const OGRRawPoint &origin)
+{
+    // Closed ring needs at least 4 points
+    if(indices.size() < 4 || indices.front() != indices.back()) {
+        return nullptr;
+    }
+    GEOSCoordSequence *seq = createCoordSeq(handle, points, indices, origin);
+    if(nullptr == seq) {
+        return nullptr;
+    }
+    return GEOSGeom_createLinearRing_r(handle, seq);
+}
+
+static GEOSGeom createPolygon(GEOSContextHandle_t handle,
+                              const VectorTileItem &item,
+                              const OGRRawPoint &origin)
+{
+    const auto &borders = item.borderIndices();
+    if(borders.empty()) {
+        return nullptr;
+    }
+
+    GEOSGeom shell = createRing(handle, item.points(), borders[0], origin);
+    if(nullptr == shell) {
+        return nullptr;
+    }
+
+    std::vector<GEOSGeom> holes;
+    for(size_t i = 1; i < borders.size(); ++i) {
+        GEOSGeom hole = createRing(handle, item.points(), borders[i], origin);
+        if(nullptr != hole) {
+            holes.push_back(hole);
+        }
+    }
+
+    return GEOSGeom_createPolygon_r(handle, shell, holes.data(),
+                                    static_cast<unsigned int>(holes.size()));
+}
+
+/**
+ * @brief GEOSGeometryWrap::createFromTileItems Restores geometry from tile
+ * items of one feature. Pieces clipped by neighbour tiles are dissolved, lines
+ * are merged.
+ * @param items Tile items of feature with origins of their tiles, i.e. from
+ * child tiles.
+ * @param type Feature class geometry type.
+ * @return Geometry or empty pointer.
+ */
+GEOSGeometryPtr GEOSGeometryWrap::createFromTileItems(
+        const std::vector<VectorTileItemRef> &items,
+        OGRwkbGeometryType type)
+{
+    GEOSContextHandlePtr handle = GEOSContextHandlePtr::threadHandle();
+    GEOSContextHandle_t h = handle.get();
+
+    int collectionType;
+    std::vector<GEOSGeom> geoms;
+    switch(OGR_GT_Flatten(type)) {
+    case wkbPoint:
+    case wkbMultiPoint:
+        collectionType = GEOS_MULTIPOINT;
+        for(const auto &item : items) {
+            const OGRRawPoint &origin = item.second;
+            for(const auto &pt : item.first->points()) {
+                GEOSCoordSequence *seq = GEOSCoordSeq_create_r(h, 1, 2);
+                GEOSCoordSeq_setX_r(h, seq, 0,
+                                    origin.x + static_cast<double>(pt.x));
+                GEOSCoordSeq_setY_r(h, seq, 0,
+                                    origin.y + static_cast<double>(pt.y));
+                geoms.push_back(GEOSGeom_createPoint_r(h, seq));
+            }
+        }
+        break;
+    case wkbLineString:
+    case wkbMultiLineString:
+        collectionType = GEOS_MULTILINESTRING;
+        for(const auto &item : items) {
+            if(item.first->pointCount() < 2) {
+                continue;
+            }
+            std::vector<unsigned short> indices(item.first->pointCount());
+            for(size_t i = 0; i < indices.size(); ++i) {
+                indices[i] = static_cast<unsigned short>(i);
+            }
+            GEOSCoordSequence *seq = createCoordSeq(h, item.first->points(),
+                                                    indices, item.second);
+            if(nullptr != seq) {
+                geoms.push_back(GEOSGeom_createLineString_r(h, seq));
+            }
+        }
+        break;
+    case wkbPolygon:
+    case wkbMultiPolygon:
+        collectionType = GEOS_MULTIPOLYGON;
+        for(const auto &item : items) {
+            GEOSGeom polygon = createPolygon(h, *item.first, item.second);
+            if(nullptr != polygon) {
+                geoms.push_back(polygon);
+            }
+        }
+        break;
+    default:
+        return GEOSGeometryPtr();
+    }
+
+    if(geoms.empty()) {
+        return GEOSGeometryPtr();
+    }
+
+    GEOSGeom result = GEOSGeom_createCollection_r(h, collectionType,
+            geoms.data(), static_cast<unsigned int>(geoms.size()));
+    if(collectionType != GEOS_MULTIPOINT && geoms.size() > 1) {
+        // Pieces overlap in tiles extra extent
+        GEOSGeom unionGeom = GEOSUnaryUnion_r(h, result);
+        if(nullptr == unionGeom && collectionType == GEOS_MULTIPOLYGON) {
+            GEOSGeom fixedGeom = GEOSBuffer_r(h, result, 0.0, 8);
+            if(nullptr != fixedGeom) {
+                unionGeom = GEOSUnaryUnion_r(h, fixedGeom);
+                GEOSGeom_destroy_r(h, fixedGeom);
+            }
+        }
+
+        if(nullptr != unionGeom) {
+            GEOSGeom_destroy_r(h, result);
+            result = unionGeom;
+        }
+
+        if(collectionType == GEOS_MULTILINESTRING) {
+            GEOSGeom mergedGeom = GEOSLineMerge_r(h, result);
+            if(nullptr != mergedGeom) {
+                GEOSGeom_destroy_r(h, result);
+                result = mergedGeom;
+            }
+        }
+    }
+
+    return GEOSGeometryPtr(new GEOSGeometryWrap(result, handle));
+}
+
+/**
+ * @brief GEOSGeometryWrap::simplifyTypeFromString Parses simplify type option.
+ * @param name Type name: grid, dp (douglas_peucker) or vw (visvalingam).
+ * @return Simplify type. Grid if name is unknown or empty.
+ */
+GEOSGeometryWrap::SimplifyType GEOSGeometryWrap::simplifyTypeFromString(
+        const std::string &name)
+{
+    if(compare(name, "dp") || compare(name, "douglas_peucker")) {
+        return SimplifyType::DOUGLAS_PEUCKER;
+    }
+    if(compare(name, "vw") || compare(name, "visvalingam")) {
+        return SimplifyType::VISVALINGAM;
+    }
+    return SimplifyType::GRID;
+}
+
 //------------------------------------------------------------------------------
 
 /**
@@ -1651,6 +3041,19 @@ OGRRawPoint ngsGetMiddlePoint(const OGRRawPoint &pt1, const OGRRawPoint &pt2)
     return OGRRawPoint((pt2.x - pt1.x) / 2 + pt1.x, (pt2.y - pt1.y) / 2 + pt1.y);
 }
 
+/**
+ * @brief ngsTileOrigin Returns minimum corner of the tile envelope. Tile items
+ * coordinates are relative to it, so they keep float precision at any zoom.
+ * @param tile Tile.
+ * @return Origin point in map units.
+ */
+OGRRawPoint ngsTileOrigin(const Tile &tile)
+{
+    double tileSize = DEFAULT_BOUNDS.width() / (1 << tile.z);
+    return OGRRawPoint(DEFAULT_BOUNDS.minX() + tile.x * tileSize,
+                       DEFAULT_BOUNDS.minY() + tile.y * tileSize);
+}
+
 //------------------------------------------------------------------------------
 // EditGeometryData
 //------------------------------------------------------------------------------
@@ -2043,7 +3446,7 @@ GEOSGeom EditLine::toGEOSGeometry(GEOSContextHandlePtr handle) const
 ngsPointId EditLine::selectNearestPoint(const OGRRawPoint &pt, double tolerance)
 {
     // Check if line selected
-    GEOSContextHandlePtr handle;
+    GEOSContextHandlePtr handle = GEOSContextHandlePtr::threadHandle();
 
     GEOSGeometryWrap geosLineString(toGEOSGeometry(handle), handle);
     if(geosLineString.distance(pt.x, pt.y) > tolerance ) {
@@ -2286,7 +3689,7 @@ ngsPointId EditPolygon::selectNearestPoint(const OGRRawPoint &pt, double toleran
     }
 
     // Check if hole selected
-    GEOSContextHandlePtr handle;
+    GEOSContextHandlePtr handle = GEOSContextHandlePtr::threadHandle();
     unsigned numHoles = static_cast<unsigned>(m_data.m_data.size() - 1);
     for(unsigned i = 0; i < numHoles; ++i) {
         Line &ring = m_data.m_data[i + 1];
@@ -2711,7 +4114,7 @@ ngsPointId EditMultiLine::selectNearestPoint(const OGRRawPoint &pt,
                                              double tolerance)
 {
     // Check if line selected
-    GEOSContextHandlePtr handle;
+    GEOSContextHandlePtr handle = GEOSContextHandlePtr::threadHandle();
 
     GEOSGeometryWrap geosLineString(toGEOSGeometry(handle), handle);
     if(geosLineString.distance(pt.x, pt.y) > tolerance ) {
@@ -3026,7 +4429,7 @@ ngsPointId EditMultiPolygon::selectNearestPoint(const OGRRawPoint &pt, double to
     m_selectedPart = 0;
     for(const Polygon &polygon : m_data.m_data) {
         // Check if hole selected
-        GEOSContextHandlePtr handle;
+        GEOSContextHandlePtr handle = GEOSContextHandlePtr::threadHandle();
         unsigned numHoles = static_cast<unsigned>(polygon.size() - 1);
         for(unsigned i = 0; i < numHoles; ++i) {
 
@@ -27,9 +27,11 @@
 #include "ogr_geometry.h"
 
 // std
+#include <algorithm>
 #include <array>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 #include "api_priv.h"
 #include "ngstore/util/constants.h"
@@ -143,6 +145,28 @@ typedef struct _tileItem{
     Envelope env;
 } TileItem;
 
+/**
+ * @brief TileKey Tile packed to 64 bit integer: x and y by 24 bits, zoom and
+ * crossExtent by 8 bits. Keys are sorted in the same order as tiles. Valid for
+ * zoom levels up to 24.
+ */
+using TileKey = GUIntBig;
+
+inline TileKey ngsTileKey(const Tile &tile) {
+    return (static_cast<TileKey>(tile.x & 0xFFFFFF) << 40) |
+            (static_cast<TileKey>(tile.y & 0xFFFFFF) << 16) |
+            (static_cast<TileKey>(tile.z) << 8) |
+            static_cast<TileKey>(static_cast<GByte>(tile.crossExtent + 128));
+}
+
+inline Tile ngsTileFromKey(TileKey key) {
+    Tile tile = {static_cast<int>((key >> 40) & 0xFFFFFF),
+                 static_cast<int>((key >> 16) & 0xFFFFFF),
+                 static_cast<unsigned char>((key >> 8) & 0xFF),
+                 static_cast<char>(static_cast<int>(key & 0xFF) - 128)};
+    return tile;
+}
+
 OGRGeometry *ngsCreateGeometryFromGeoJson(const CPLJSONObject &json);
 
 bool ngsIsGeometryIntersectsEnvelope(const OGRGeometry &geometry,
@@ -150,6 +174,70 @@ bool ngsIsGeometryIntersectsEnvelope(const OGRGeometry &geometry,
 double ngsDistance(const OGRRawPoint &pt1, const OGRRawPoint &pt2);
 bool ngsIsNear(const OGRRawPoint &pt1, const OGRRawPoint &pt2, double tolerance);
 OGRRawPoint ngsGetMiddlePoint(const OGRRawPoint &pt1, const OGRRawPoint &pt2);
+OGRRawPoint ngsTileOrigin(const Tile &tile);
+
+/**
+ * @brief The FeatureIdSet class. Sorted set of feature identifiers stored in
+ * contiguous array. Single identifier, which is most common for tile items,
+ * is stored without heap allocation.
+ */
+class FeatureIdSet
+{
+public:
+    using const_iterator = const GIntBig*;
+
+public:
+    FeatureIdSet() : m_id(0), m_count(0) {}
+    template<class InputIt>
+    FeatureIdSet(InputIt first, InputIt last) : m_id(0), m_count(0) {
+        insert(first, last);
+    }
+    void insert(GIntBig id);
+    // Ids are appended and sorted once, as inserting unsorted ids one by one
+    // is quadratic.
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        if(first == last) {
+            return;
+        }
+        if(1 == m_count) {
+            m_ids.push_back(m_id);
+        }
+        for(; first != last; ++first) {
+            m_ids.push_back(static_cast<GIntBig>(*first));
+        }
+        normalize();
+    }
+    bool erase(GIntBig id);
+    void clear();
+    bool contains(GIntBig id) const;
+    bool intersects(const FeatureIdSet &other) const;
+    bool isSubsetOf(const FeatureIdSet &other) const;
+    FeatureIdSet intersection(const FeatureIdSet &other) const;
+    bool empty() const { return 0 == m_count; }
+    size_t size() const { return m_count; }
+    size_t memorySize() const;
+    const_iterator begin() const { return m_count > 1 ? m_ids.data() : &m_id; }
+    const_iterator end() const { return begin() + m_count; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    bool operator==(const FeatureIdSet &other) const {
+        return m_count == other.m_count &&
+                std::equal(begin(), end(), other.begin());
+    }
+    bool operator<(const FeatureIdSet &other) const {
+        return std::lexicographical_compare(begin(), end(),
+                                            other.begin(), other.end());
+    }
+
+private:
+    void normalize();
+
+private:
+    GIntBig m_id;
+    std::vector<GIntBig> m_ids;
+    size_t m_count;
+};
 
 class VectorTileItem
 {
@@ -176,40 +264,58 @@ public:
     bool operator==(const VectorTileItem &other) const {
         return m_points == other.m_points;
     }
-    bool isIdsPresent(const std::set<GIntBig> &other, bool full = true) const;
-    std::set<GIntBig> idsIntesect(const std::set<GIntBig> &other) const;
+    bool isIdsPresent(const FeatureIdSet &other, bool full = true) const;
+    FeatureIdSet idsIntesect(const FeatureIdSet &other) const;
+    const FeatureIdSet &ids() const { return m_ids; }
+    size_t memorySize() const;
+    GUInt64 hash() const;
 
 protected:
     void loadIds(const VectorTileItem &item);
-    void save(Buffer *buffer);
+    void save(Buffer *buffer, const OGRRawPoint &origin, double step) const;
     bool load(Buffer &buffer);
+    bool load(Buffer &buffer, bool idRanges, const OGRRawPoint &origin,
+              double step);
 private:
     std::vector<SimplePoint> m_points;
     std::vector<unsigned short> m_indices;
     std::vector<std::vector<unsigned short>> m_borderIndices; // NOTE: first array is exterior ring indices
     std::vector<SimplePoint> m_centroids;
-    std::set<GIntBig> m_ids;
+    FeatureIdSet m_ids;
     bool m_valid;
     bool m_2d;
 };
 
 using VectorTileItemArray = std::vector<VectorTileItem>;
+// Tile item and origin of the tile it belongs to
+using VectorTileItemRef = std::pair<const VectorTileItem*, OGRRawPoint>;
 
 class VectorTile
 {
 public:
-    VectorTile() : m_valid(false) {}
-    void add(const VectorTileItem &item, bool checkDuplicates = false);
-    void add(const VectorTileItemArray &items, bool checkDuplicates = false);
+    VectorTile() : m_valid(false), m_indexedCount(0) {}
+    size_t add(const VectorTileItem &item, bool checkDuplicates = false);
+    size_t add(const VectorTileItemArray &items, bool checkDuplicates = false);
     void remove(GIntBig id);
-    BufferPtr save();
-    bool load(Buffer &buffer);
-    VectorTileItemArray items() const { return m_items; }
+    BufferPtr save(double step = 0.0, bool compress = false) const;
+    bool load(Buffer &buffer, const OGRRawPoint &origin = OGRRawPoint());
+    const VectorTileItemArray &items() const { return m_items; }
     bool empty() const;
     bool isValid() const { return m_valid; }
+    size_t memorySize() const;
+private:
+    bool loadV1(Buffer &buffer, const OGRRawPoint &shift);
+    bool loadV2(Buffer &buffer, bool idRanges, const OGRRawPoint &shift);
+    void moveItems(const OGRRawPoint &shift, size_t first);
+    VectorTileItemArray::iterator findItem(const VectorTileItem &item,
+                                           GUInt64 hash);
 private:
     VectorTileItemArray m_items;
     bool m_valid;
+    // Item geometry hash to item index. Items appended without duplicates
+    // check are indexed on next check.
+    std::unordered_multimap<GUInt64, size_t> m_index;
+    size_t m_indexedCount;
 };
 
 class GEOSContextHandlePtr : public std::shared_ptr<struct GEOSContextHandle_HS>
@@ -217,12 +323,20 @@ class GEOSContextHandlePtr : public std::shared_ptr<struct GEOSContextHandle_HS>
 public:
     GEOSContextHandlePtr() : shared_ptr(OGRGeometry::createGEOSContext(),
                                         OGRGeometry::freeGEOSContext) {}
+    static GEOSContextHandlePtr threadHandle();
 };
 
 class GEOSGeometryWrap;
 using  GEOSGeometryPtr = std::shared_ptr<GEOSGeometryWrap>;
 class GEOSGeometryWrap
 {
+public:
+    enum class SimplifyType {
+        GRID,
+        DOUGLAS_PEUCKER,
+        VISVALINGAM
+    };
+
 public:
     explicit GEOSGeometryWrap(GEOSGeom geom, GEOSContextHandlePtr handle);
     explicit GEOSGeometryWrap(OGRGeometry *geom);
@@ -230,12 +344,23 @@ public:
     GEOSGeom geom() const { return m_geom; }
     int type() const;
     GEOSGeometryPtr clip(const Envelope &env) const;
-    void simplify(double step);
+    void simplify(double step, SimplifyType simplifyType = SimplifyType::GRID);
     bool isValid() const { return m_geom != nullptr; }
-    void fillTile(GIntBig fid, VectorTileItemArray &vitemArray);
+    void fillTile(GIntBig fid, VectorTileItemArray &vitemArray,
+                  const OGRRawPoint &origin = OGRRawPoint());
+    void fillClippedTile(GIntBig fid, const Envelope &env,
+                         VectorTileItemArray &vitemArray,
+                         const OGRRawPoint &origin = OGRRawPoint());
     double distance(double x, double y) const;
     bool intersects(double x, double y) const;
 
+    // static
+public:
+    static GEOSGeometryPtr createFromTileItems(
+            const std::vector<VectorTileItemRef> &items,
+            OGRwkbGeometryType type);
+    static SimplifyType simplifyTypeFromString(const std::string &name);
+
 private:
     GEOSGeom generalizePoint(const GEOSGeom_t *geom, double step);
     GEOSGeom generalizeMultiPoint(const GEOSGeom_t *geom, double step);
@@ -243,6 +368,7 @@ private:
     GEOSGeom generalizeMultiLine(const GEOSGeom_t *geom, double step);
     GEOSGeom generalizePolygon(const GEOSGeom_t *geom, double step);
     GEOSGeom generalizeMultiPolygon(const GEOSGeom_t *geom, double step);
+    GEOSGeom simplifyPolygonRings(const GEOSGeom_t *geom, double step);
     void setCentroid(int type);
     void fillPointTile(GIntBig fid, const GEOSGeom_t *geom,
                        VectorTileItemArray& vitemArray);
@@ -258,10 +384,32 @@ private:
                        VectorTileItemArray &vitemArray);
     void fillCollectionTile(GIntBig fid, const GEOSGeom_t *geom,
                        VectorTileItemArray &vitemArray);
+    void buildFlatGeometry();
+    bool addFlatGeometry(const GEOSGeom_t *geom);
+    std::vector<OGRRawPoint> flatPoints(const GEOSGeom_t *geom) const;
+    static void fillPolygonRings(GIntBig fid,
+                                 const std::vector<std::vector<OGRRawPoint>> &rings,
+                                 const OGRRawPoint &origin,
+                                 VectorTileItemArray &vitemArray,
+                                 bool degenerateFallback = true);
+
+private:
+    // Coordinates copy for clipping without GEOS
+    struct FlatGeometry {
+        bool ready = false;
+        bool useGeos = false;
+        std::vector<OGRRawPoint> points;
+        std::vector<std::vector<OGRRawPoint>> lines;
+        std::vector<std::vector<std::vector<OGRRawPoint>>> polygons;
+    };
 
 private:
     GEOSGeom m_geom;
     GEOSContextHandlePtr m_geosHandle;
+    SimplifyType m_simplifyType;
+    FlatGeometry m_flat;
+    // Tile items coordinates are relative to this point
+    OGRRawPoint m_tileOrigin;
 };
 
 /**
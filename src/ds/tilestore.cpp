@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Project:  libngstore
+ * Purpose:  NextGIS store and visualization support library
+ * Author: Dmitry Baryshnikov, dmitry.baryshnikov@nextgis.com
+ ******************************************************************************
+ *   Copyright (c) 2016-2020 NextGIS, <info@nextgis.com>
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Lesser General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "tilestore.h"
+
+#ifdef HAVE_SQLITE3_H
+#include "sqlite3.h"
+#endif
+
+#include "dataset.h"
+
+#include "util/error.h"
+
+namespace ngs {
+
+#ifdef HAVE_SQLITE3_H
+
+//------------------------------------------------------------------------------
+// OverviewTileStore
+//------------------------------------------------------------------------------
+
+OverviewTileStore::OverviewTileStore(GDALDataset *ds,
+                                     const std::string &tableName) :
+    m_db(nullptr),
+    m_tableName(tableName),
+    m_selectRowid(nullptr),
+    m_selectRange(nullptr),
+    m_insert(nullptr),
+    m_update(nullptr),
+    m_delete(nullptr)
+{
+    if(nullptr == ds) {
+        return;
+    }
+
+    // GeoPackage and SQLite drivers share their connection
+    m_db = static_cast<sqlite3*>(ds->GetInternalHandle("SQLITE_HANDLE"));
+    if(nullptr == m_db) {
+        CPLDebug("ngstore", "SQLite handle is not available for %s",
+                 tableName.c_str());
+        return;
+    }
+
+    char *sql = sqlite3_mprintf("SELECT rowid FROM \"%w\" WHERE %s = ? AND "
+                                "%s = ? AND %s = ? LIMIT 1", tableName.c_str(),
+                                OVR_ZOOM_KEY, OVR_X_KEY, OVR_Y_KEY);
+    m_selectRowid = prepare(sql);
+    sqlite3_free(sql);
+
+    sql = sqlite3_mprintf("SELECT %s, %s, %s FROM \"%w\" WHERE %s = ? AND "
+                          "%s BETWEEN ? AND ? AND %s BETWEEN ? AND ?",
+                          OVR_X_KEY, OVR_Y_KEY, OVR_TILE_KEY, tableName.c_str(),
+                          OVR_ZOOM_KEY, OVR_X_KEY, OVR_Y_KEY);
+    m_selectRange = prepare(sql);
+    sqlite3_free(sql);
+
+    sql = sqlite3_mprintf("INSERT INTO \"%w\" (%s, %s, %s, %s) "
+                          "VALUES (?, ?, ?, ?)", tableName.c_str(),
+                          OVR_ZOOM_KEY, OVR_X_KEY, OVR_Y_KEY, OVR_TILE_KEY);
+    m_insert = prepare(sql);
+    sqlite3_free(sql);
+
+    sql = sqlite3_mprintf("UPDATE \"%w\" SET %s = ? WHERE %s = ? AND %s = ? "
+                          "AND %s = ?", tableName.c_str(), OVR_TILE_KEY,
+                          OVR_ZOOM_KEY, OVR_X_KEY, OVR_Y_KEY);
+    m_update = prepare(sql);
+    sqlite3_free(sql);
+
+    sql = sqlite3_mprintf("DELETE FROM \"%w\" WHERE %s = ? AND %s = ? "
+                          "AND %s = ?", tableName.c_str(), OVR_ZOOM_KEY,
+                          OVR_X_KEY, OVR_Y_KEY);
+    m_delete = prepare(sql);
+    sqlite3_free(sql);
+
+    if(nullptr == m_selectRowid || nullptr == m_selectRange ||
+       nullptr == m_insert || nullptr == m_update || nullptr == m_delete) {
+        errorMessage(_("Failed to prepare tile store statements. %s"),
+                     sqlite3_errmsg(m_db));
+        m_db = nullptr;
+    }
+}
+
+OverviewTileStore::~OverviewTileStore()
+{
+    sqlite3_finalize(m_selectRowid);
+    sqlite3_finalize(m_selectRange);
+    sqlite3_finalize(m_insert);
+    sqlite3_finalize(m_update);
+    sqlite3_finalize(m_delete);
+}
+
+sqlite3_stmt *OverviewTileStore::prepare(const char *sql)
+{
+    sqlite3_stmt *stmt = nullptr;
+    if(sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    return stmt;
+}
+
+bool OverviewTileStore::bindTile(sqlite3_stmt *stmt, const Tile &tile,
+                                 int startIndex)
+{
+    sqlite3_reset(stmt);
+    return sqlite3_bind_int(stmt, startIndex, tile.z) == SQLITE_OK &&
+            sqlite3_bind_int(stmt, startIndex + 1, tile.x) == SQLITE_OK &&
+            sqlite3_bind_int(stmt, startIndex + 2, tile.y) == SQLITE_OK;
+}
+
+/**
+ * @brief OverviewTileStore::readTile Reads tile data with incremental BLOB I/O.
+ * @param tile Tile to read.
+ * @param data Output tile data. Empty if tile is not present.
+ * @return False on error.
+ */
+bool OverviewTileStore::readTile(const Tile &tile, std::vector<GByte> &data)
+{
+    data.clear();
+    if(!isOpened() || !bindTile(m_selectRowid, tile)) {
+        return false;
+    }
+
+    int result = sqlite3_step(m_selectRowid);
+    if(result == SQLITE_DONE) {
+        sqlite3_reset(m_selectRowid);
+        return true;
+    }
+    if(result != SQLITE_ROW) {
+        sqlite3_reset(m_selectRowid);
+        return false;
+    }
+    sqlite3_int64 rowid = sqlite3_column_int64(m_selectRowid, 0);
+    sqlite3_reset(m_selectRowid);
+
+    // Blob handle is closed at once, not to keep read transaction open.
+    sqlite3_blob *blob = nullptr;
+    if(sqlite3_blob_open(m_db, "main", m_tableName.c_str(), OVR_TILE_KEY,
+                         rowid, 0, &blob) != SQLITE_OK) {
+        sqlite3_blob_close(blob);
+        return false;
+    }
+
+    int size = sqlite3_blob_bytes(blob);
+    data.resize(static_cast<size_t>(size));
+    bool out = size == 0 ||
+            sqlite3_blob_read(blob, data.data(), size, 0) == SQLITE_OK;
+    sqlite3_blob_close(blob);
+    if(!out) {
+        data.clear();
+    }
+    return out;
+}
+
+/**
+ * @brief OverviewTileStore::readTiles Reads all stored tiles of zoom level in
+ * tile ranges with one query.
+ * @param z Zoom level.
+ * @param minX Minimum tile X.
+ * @param minY Minimum tile Y.
+ * @param maxX Maximum tile X.
+ * @param maxY Maximum tile Y.
+ * @param tiles Output tiles.
+ * @return False on error.
+ */
+bool OverviewTileStore::readTiles(unsigned char z, int minX, int minY,
+                                  int maxX, int maxY,
+                                  std::vector<TileData> &tiles)
+{
+    if(!isOpened()) {
+        return false;
+    }
+
+    sqlite3_reset(m_selectRange);
+    sqlite3_bind_int(m_selectRange, 1, z);
+    sqlite3_bind_int(m_selectRange, 2, minX);
+    sqlite3_bind_int(m_selectRange, 3, maxX);
+    sqlite3_bind_int(m_selectRange, 4, minY);
+    sqlite3_bind_int(m_selectRange, 5, maxY);
+
+    int result;
+    while((result = sqlite3_step(m_selectRange)) == SQLITE_ROW) {
+        Tile tile = {sqlite3_column_int(m_selectRange, 0),
+                     sqlite3_column_int(m_selectRange, 1), z, 0};
+        const GByte *data = static_cast<const GByte*>(
+                    sqlite3_column_blob(m_selectRange, 2));
+        int size = sqlite3_column_bytes(m_selectRange, 2);
+        tiles.push_back(std::make_pair(tile,
+                                       std::vector<GByte>(data, data + size)));
+    }
+    sqlite3_reset(m_selectRange);
+    return result == SQLITE_DONE;
+}
+
+bool OverviewTileStore::insertTile(const Tile &tile, const GByte *data,
+                                   size_t size)
+{
+    if(!isOpened() || !bindTile(m_insert, tile)) {
+        return false;
+    }
+
+    sqlite3_bind_blob(m_insert, 4, data, static_cast<int>(size),
+                      SQLITE_STATIC);
+    bool result = sqlite3_step(m_insert) == SQLITE_DONE;
+    sqlite3_reset(m_insert);
+    sqlite3_clear_bindings(m_insert);
+    return result;
+}
+
+bool OverviewTileStore::writeTile(const Tile &tile, const GByte *data,
+                                  size_t size)
+{
+    if(!isOpened() || !bindTile(m_update, tile, 2)) {
+        return false;
+    }
+
+    sqlite3_bind_blob(m_update, 1, data, static_cast<int>(size),
+                      SQLITE_STATIC);
+    bool result = sqlite3_step(m_update) == SQLITE_DONE;
+    sqlite3_reset(m_update);
+    sqlite3_clear_bindings(m_update);
+    if(!result) {
+        return false;
+    }
+
+    if(sqlite3_changes(m_db) == 0) {
+        return insertTile(tile, data, size);
+    }
+    return true;
+}
+
+bool OverviewTileStore::deleteTile(const Tile &tile)
+{
+    if(!isOpened() || !bindTile(m_delete, tile)) {
+        return false;
+    }
+
+    bool result = sqlite3_step(m_delete) == SQLITE_DONE;
+    sqlite3_reset(m_delete);
+    return result;
+}
+
+#else
+
+OverviewTileStore::OverviewTileStore(GDALDataset *ds,
+                                     const std::string &tableName) :
+    m_db(nullptr),
+    m_tableName(tableName),
+    m_selectRowid(nullptr),
+    m_selectRange(nullptr),
+    m_insert(nullptr),
+    m_update(nullptr),
+    m_delete(nullptr)
+{
+    ngsUnused(ds);
+}
+
+OverviewTileStore::~OverviewTileStore()
+{
+}
+
+bool OverviewTileStore::readTile(const Tile &tile, std::vector<GByte> &data)
+{
+    ngsUnused(tile);
+    data.clear();
+    return false;
+}
+
+bool OverviewTileStore::readTiles(unsigned char z, int minX, int minY,
+                                  int maxX, int maxY,
+                                  std::vector<TileData> &tiles)
+{
+    ngsUnused(z);
+    ngsUnused(minX);
+    ngsUnused(minY);
+    ngsUnused(maxX);
+    ngsUnused(maxY);
+    ngsUnused(tiles);
+    return false;
+}
+
+bool OverviewTileStore::insertTile(const Tile &tile, const GByte *data,
+                                   size_t size)
+{
+    ngsUnused(tile);
+    ngsUnused(data);
+    ngsUnused(size);
+    return false;
+}
+
+bool OverviewTileStore::writeTile(const Tile &tile, const GByte *data,
+                                  size_t size)
+{
+    ngsUnused(tile);
+    ngsUnused(data);
+    ngsUnused(size);
+    return false;
+}
+
+bool OverviewTileStore::deleteTile(const Tile &tile)
+{
+    ngsUnused(tile);
+    return false;
+}
+
+#endif // HAVE_SQLITE3_H
+
+} // namespace ngs
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * Project:  libngstore
+ * Purpose:  NextGIS store and visualization support library
+ * Author: Dmitry Baryshnikov, dmitry.baryshnikov@nextgis.com
+ ******************************************************************************
+ *   Copyright (c) 2016-2020 NextGIS, <info@nextgis.com>
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU Lesser General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#ifndef NGSTILESTORE_H
+#define NGSTILESTORE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// gdal
+#include "gdal_priv.h"
+
+#include "geometry.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace ngs {
+
+/**
+ * @brief The OverviewTileStore class. Reads and writes overview tiles with
+ * prepared statements keyed on (z, x, y), bypassing OGR features. Uses the
+ * SQLite connection of the dataset, so the caller must hold the dataset SQL
+ * lock. If the dataset does not expose SQLite handle the store is not opened.
+ */
+class OverviewTileStore
+{
+public:
+    using TileData = std::pair<Tile, std::vector<GByte>>;
+
+public:
+    OverviewTileStore(GDALDataset *ds, const std::string &tableName);
+    ~OverviewTileStore();
+    bool isOpened() const { return m_db != nullptr; }
+    bool readTile(const Tile &tile, std::vector<GByte> &data);
+    bool readTiles(unsigned char z, int minX, int minY, int maxX, int maxY,
+                   std::vector<TileData> &tiles);
+    bool insertTile(const Tile &tile, const GByte *data, size_t size);
+    bool writeTile(const Tile &tile, const GByte *data, size_t size);
+    bool deleteTile(const Tile &tile);
+
+private:
+    sqlite3_stmt *prepare(const char *sql);
+    bool bindTile(sqlite3_stmt *stmt, const Tile &tile, int startIndex = 1);
+
+private:
+    sqlite3 *m_db;
+    std::string m_tableName;
+    sqlite3_stmt *m_selectRowid;
+    sqlite3_stmt *m_selectRange;
+    sqlite3_stmt *m_insert;
+    sqlite3_stmt *m_update;
+    sqlite3_stmt *m_delete;
+};
+
+using OverviewTileStorePtr = std::unique_ptr<OverviewTileStore>;
+
+} // namespace ngs
+
+#endif // NGSTILESTORE_H
@@ -53,6 +53,8 @@ public:
     }
 
     void addVertex(float value) { m_vertices.push_back(value); }
+    float vertex(size_t index) const { return m_vertices[index]; }
+    void setVertex(size_t index, float value) { m_vertices[index] = value; }
     void addIndex(unsigned short value) { m_indices.push_back(value); }
 
     enum BufferType type() const { return m_type; }
@@ -64,6 +66,10 @@ public:
     virtual void bind() override;
     virtual void rebind() const override;
     virtual void destroy() override;
+    virtual size_t dataSize() const override {
+        return m_vertices.size() * sizeof(GLfloat) +
+                m_indices.size() * sizeof(GLushort);
+    }
 
 
 private:
@@ -111,6 +111,8 @@ public:
     virtual void rebind() const = 0;
     virtual bool bound() const { return m_bound; }
     virtual void destroy() = 0;
+    // Approximate memory size of data to draw
+    virtual size_t dataSize() const { return 0; }
 
 protected:
     bool m_bound;
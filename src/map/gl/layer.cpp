@@ -40,7 +40,8 @@ constexpr double LOCK_TIME = 5.0;
 // GlRenderLayer
 //------------------------------------------------------------------------------
 
-GlRenderLayer::GlRenderLayer()
+GlRenderLayer::GlRenderLayer() :
+    m_generation(0)
 {
 }
 
@@ -51,7 +52,7 @@ GlRenderLayer::~GlRenderLayer()
 void GlRenderLayer::free(const GlTilePtr &tile)
 {
     MutexHolder holder(m_dataMutex, LOCK_TIME);
-    auto it = m_tiles.find(tile->getTile());
+    auto it = m_tiles.find(ngsTileKey(tile->getTile()));
     if(it != m_tiles.end()) {
         if(it->second) {
             it->second->destroy();
@@ -66,6 +67,22 @@ void GlRenderLayer::free(const GlTilePtr &tile)
     // CPLDebug("ngstore", "GlRenderLayer::free: %ld GlObject in layer", m_tiles.size());
 }
 
+bool GlRenderLayer::hasTileData(const Tile &tile)
+{
+    MutexHolder holder(m_dataMutex, LOCK_TIME);
+    return m_tiles.find(ngsTileKey(tile)) != m_tiles.end();
+}
+
+size_t GlRenderLayer::tileDataSize(const Tile &tile)
+{
+    MutexHolder holder(m_dataMutex, LOCK_TIME);
+    auto it = m_tiles.find(ngsTileKey(tile));
+    if(it == m_tiles.end() || !it->second) {
+        return 0;
+    }
+    return it->second->dataSize();
+}
+
 CPLJSONObject GlRenderLayer::style() const
 {
 	if(m_style) {
@@ -85,6 +102,7 @@ std::string GlRenderLayer::styleName() const
 bool GlRenderLayer::setStyle(const CPLJSONObject &style)
 {
     if(m_style) {
+        updateGeneration();
         return m_style->load(style);
     }
     return false;
@@ -105,27 +123,28 @@ bool GlFeatureLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
     ngsUnused(isLastTry);
     if(!(m_visible && tile->getTile().z > m_minZoom && tile->getTile().z < m_maxZoom)) {
         MutexHolder holder(m_dataMutex, LOCK_TIME);
-        m_tiles[tile->getTile()] = GlObjectPtr();
+        m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
         return true;
     }
 
     VectorGlObject *bufferArray = nullptr;
-    VectorTile vtile = m_featureClass->getTile(tile->getTile(), tile->getExtent());
-    if(vtile.empty()) {
+    VectorTilePtr vtile = m_featureClass->getTile(tile->getTile(),
+                                                  tile->getExtent());
+    if(vtile->empty()) {
         MutexHolder holder(m_dataMutex, LOCK_TIME);
-        m_tiles[tile->getTile()] = GlObjectPtr();
+        m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
         return true;
     }
 
     switch(m_style->type()) {
     case ST_POINT:
-        bufferArray = fillPoints(vtile, z);
+        bufferArray = fillPoints(*vtile, z);
         break;
     case ST_LINE:
-        bufferArray = fillLines(vtile, z);
+        bufferArray = fillLines(*vtile, z);
         break;
     case ST_FILL:
-        bufferArray = fillPolygons(vtile, z);
+        bufferArray = fillPolygons(*vtile, z);
         break;
     case ST_IMAGE:
         return true;
@@ -133,12 +152,12 @@ bool GlFeatureLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
 
     if(!bufferArray) {
         MutexHolder holder(m_dataMutex, LOCK_TIME);
-        m_tiles[tile->getTile()] = GlObjectPtr();
+        m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
         return true;
     }
 
     MutexHolder holder(m_dataMutex, LOCK_TIME);
-    m_tiles[tile->getTile()] = GlObjectPtr(bufferArray);
+    m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr(bufferArray);
 
     return true;
 }
@@ -153,7 +172,7 @@ bool GlFeatureLayer::draw(const GlTilePtr &tile)
     }
 
     MutexHolder holder(m_dataMutex, 5);
-    auto tileDataIt = m_tiles.find(tile->getTile());
+    auto tileDataIt = m_tiles.find(ngsTileKey(tile->getTile()));
     if(tileDataIt == m_tiles.end()) {
         return false; // Data not yet loaded
     }
@@ -172,7 +191,7 @@ bool GlFeatureLayer::draw(const GlTilePtr &tile)
             buff->bind();
         }
 
-        m_style->prepare(tile->getSceneMatrix(), tile->getInvViewMatrix(),
+        m_style->prepare(tile->getLocalSceneMatrix(), tile->getInvViewMatrix(),
                          buff->type());
         m_style->draw(*buff);
     }
@@ -190,6 +209,7 @@ bool GlFeatureLayer::setStyleName(const std::string &name)
     if(newStyle) {
         m_oldStyles.push_back(m_style);
         m_style = newStyle;
+        updateGeneration();
     }
     return true;
 }
@@ -220,9 +240,30 @@ CPLJSONObject GlFeatureLayer::save(const ObjectContainer *objectContainer) const
     return out;
 }
 
+void GlFeatureLayer::setVisible(bool visible)
+{
+    if(m_visible != visible) {
+        updateGeneration();
+    }
+    FeatureLayer::setVisible(visible);
+}
+
+void GlFeatureLayer::setSelectedIds(const FeatureIDs &selectedIds)
+{
+    FeatureLayer::setSelectedIds(selectedIds);
+    updateGeneration();
+}
+
+void GlFeatureLayer::setHideIds(const FeatureIDs &hideIds)
+{
+    FeatureLayer::setHideIds(hideIds);
+    updateGeneration();
+}
+
 void GlFeatureLayer::setFeatureClass(const FeatureClassOverviewPtr &featureClass)
 {
     FeatureLayer::setFeatureClass(featureClass);
+    updateGeneration();
     GlView *mapView = dynamic_cast<GlView*>(m_map);
     switch(OGR_GT_Flatten(featureClass->geometryType())) {
     case wkbPoint:
@@ -240,17 +281,26 @@ void GlFeatureLayer::setFeatureClass(const FeatureClassOverviewPtr &featureClass
     }
 }
 
+// Cluster point size grows with members count: 10 - 2x, 100 - 3x, max 4x.
+static float clusterScale(size_t count)
+{
+    return std::min(1.0f + static_cast<float>(std::log10(count)), 4.0f);
+}
+
 VectorGlObject *GlFeatureLayer::fillPoints(const VectorTile &tile, float z)
 {
     VectorGlObject *bufferArray = new VectorGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short index = 0;
     GlBuffer *buffer = new GlBuffer(GlBuffer::BF_PT);
     PointStyle *style = ngsDynamicCast(PointStyle, m_style);
+    bool clusters = m_featureClass && m_featureClass->hasPointClusters();
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
-        if(!m_hideFIDs.empty() && tileItem.isIdsPresent(m_hideFIDs)) {
+        const VectorTileItem &tileItem = *it;
+        // Cluster is hidden only if all members are hidden, the rest are
+        // counted in its size.
+        if(!m_hideFIDs.empty() && tileItem.isIdsPresent(m_hideFIDs, true)) {
             ++it;
             continue;
         }
@@ -260,6 +310,11 @@ VectorGlObject *GlFeatureLayer::fillPoints(const VectorTile &tile, float z)
             continue;
         }
 
+        size_t visibleCount = tileItem.ids().size();
+        if(clusters && visibleCount > 1 && !m_hideFIDs.empty()) {
+            visibleCount -= tileItem.idsIntesect(m_hideFIDs).size();
+        }
+
         for(size_t i = 0; i < tileItem.pointCount(); ++i) {
             if(!buffer->canStoreVertices(style->pointVerticesCount(), true)) {
                 bufferArray->addBuffer(buffer);
@@ -268,7 +323,13 @@ VectorGlObject *GlFeatureLayer::fillPoints(const VectorTile &tile, float z)
             }
 
             const SimplePoint& pt = tileItem.point(i);
-            index = style->addPoint(pt, z, index, buffer);
+            if(clusters && visibleCount > 1) {
+                index = style->addScaledPoint(pt, clusterScale(visibleCount),
+                                              z, index, buffer);
+            }
+            else {
+                index = style->addPoint(pt, z, index, buffer);
+            }
         }
         ++it;
     }
@@ -281,14 +342,14 @@ VectorGlObject *GlFeatureLayer::fillPoints(const VectorTile &tile, float z)
 VectorGlObject *GlFeatureLayer::fillLines(const VectorTile &tile, float z)
 {
     VectorGlObject *bufferArray = new VectorGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short index = 0;
     GlBuffer *buffer = new GlBuffer(GlBuffer::BF_LINE);
     SimpleLineStyle *style = ngsStaticCast(SimpleLineStyle, m_style);
 
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
+        const VectorTileItem &tileItem = *it;
         if(tileItem.isIdsPresent(m_hideFIDs)) {
             ++it;
             continue;
@@ -366,7 +427,7 @@ VectorGlObject *GlFeatureLayer::fillLines(const VectorTile &tile, float z)
 VectorGlObject *GlFeatureLayer::fillPolygons(const VectorTile &tile, float z)
 {
     VectorGlObject *bufferArray = new VectorGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short fillIndex = 0;
     unsigned short lineIndex = 0;
@@ -375,14 +436,14 @@ VectorGlObject *GlFeatureLayer::fillPolygons(const VectorTile &tile, float z)
     SimpleLineStyle *style = ngsStaticCast(SimpleLineStyle, m_style);
 
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
+        const VectorTileItem &tileItem = *it;
         if(tileItem.isIdsPresent(m_hideFIDs)) {
             ++it;
             continue;
         }
 
-        auto points = tileItem.points();
-        auto indices = tileItem.indices();
+        const auto &points = tileItem.points();
+        const auto &indices = tileItem.indices();
 
         if(points.size() < 3 || points.size() > GlBuffer::maxIndices() ||
                 points.size() > GlBuffer::maxVertices()) {
@@ -397,7 +458,7 @@ VectorGlObject *GlFeatureLayer::fillPolygons(const VectorTile &tile, float z)
             fillBuffer = new GlBuffer(GlBuffer::BF_FILL);
         }
 
-        for(auto point : points) {
+        for(const auto &point : points) {
             fillBuffer->addVertex(point.x);
             fillBuffer->addVertex(point.y);
             fillBuffer->addVertex(z);
@@ -418,8 +479,8 @@ VectorGlObject *GlFeatureLayer::fillPolygons(const VectorTile &tile, float z)
         // FIXME: May be more styles with borders
         if(compare(m_style->name(), "simpleFillBordered")) {
 
-        auto borders = (*it).borderIndices();
-        for(auto border : borders) {
+        const auto &borders = tileItem.borderIndices();
+        for(const auto &border : borders) {
             Normal prevNormal;
             Normal firstNormal;
             bool firstNormalSet = false;
@@ -518,7 +579,7 @@ bool GlSelectableFeatureLayer::drawSelection(const GlTilePtr &tile)
     }
 
     MutexHolder holder(m_dataMutex, 5);
-    auto tileDataIt = m_tiles.find(tile->getTile());
+    auto tileDataIt = m_tiles.find(ngsTileKey(tile->getTile()));
     if(tileDataIt == m_tiles.end()) {
         return false; // Data not yet loaded
     }
@@ -539,7 +600,7 @@ bool GlSelectableFeatureLayer::drawSelection(const GlTilePtr &tile)
             buff->bind();
         }
 
-        style->prepare(tile->getSceneMatrix(), tile->getInvViewMatrix(),
+        style->prepare(tile->getLocalSceneMatrix(), tile->getInvViewMatrix(),
                        buff->type());
         style->draw(*buff);
     }
@@ -550,7 +611,7 @@ VectorGlObject* GlSelectableFeatureLayer::fillPoints(const VectorTile &tile,
                                                      float z)
 {
     VectorSelectableGlObject *bufferArray = new VectorSelectableGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short index = 0;
     GlBuffer *buffer = nullptr;
@@ -564,7 +625,7 @@ VectorGlObject* GlSelectableFeatureLayer::fillPoints(const VectorTile &tile,
     unsigned short selectIndex = 0;
 
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
+        const VectorTileItem &tileItem = *it;
         if(tileItem.isIdsPresent(m_hideFIDs, true)) {
             ++it;
             continue;
@@ -628,7 +689,7 @@ VectorGlObject *GlSelectableFeatureLayer::fillLines(const VectorTile &tile,
                                                     float z)
 {
     VectorSelectableGlObject *bufferArray = new VectorSelectableGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short index = 0;
     GlBuffer *buffer = nullptr;
@@ -641,7 +702,7 @@ VectorGlObject *GlSelectableFeatureLayer::fillLines(const VectorTile &tile,
     unsigned short selectIndex = 0;
 
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
+        const VectorTileItem &tileItem = *it;
         if(tileItem.isIdsPresent(m_hideFIDs)) {
             ++it;
             continue;
@@ -782,7 +843,7 @@ VectorGlObject *GlSelectableFeatureLayer::fillPolygons(const VectorTile& tile,
                                                        float z)
 {
     VectorSelectableGlObject *bufferArray = new VectorSelectableGlObject;
-    auto items = tile.items();
+    const auto &items = tile.items();
     auto it = items.begin();
     unsigned short fillIndex = 0;
     unsigned short lineIndex = 0;
@@ -810,14 +871,14 @@ VectorGlObject *GlSelectableFeatureLayer::fillPolygons(const VectorTile& tile,
     unsigned short drawLineIndex = 0;
 
     while(it != items.end()) {
-        VectorTileItem tileItem = *it;
+        const VectorTileItem &tileItem = *it;
         if(tileItem.isIdsPresent(m_hideFIDs)) {
             ++it;
             continue;
         }
 
-        auto points = tileItem.points();
-        auto indices = tileItem.indices();
+        const auto &points = tileItem.points();
+        const auto &indices = tileItem.indices();
 
         if(points.size() < 3 || points.size() > GlBuffer::maxIndices() ||
                 points.size() > GlBuffer::maxVertices()) {
@@ -861,7 +922,7 @@ VectorGlObject *GlSelectableFeatureLayer::fillPolygons(const VectorTile& tile,
             }
         }
 
-        for(auto point : points) {
+        for(const auto &point : points) {
             fillBuffer->addVertex(point.x);
             fillBuffer->addVertex(point.y);
             fillBuffer->addVertex(z);
@@ -884,8 +945,8 @@ VectorGlObject *GlSelectableFeatureLayer::fillPolygons(const VectorTile& tile,
         // FIXME: May be more styles with borders
         if(compare(style->name(), "simpleFillBordered")) {
 
-        auto borders = (*it).borderIndices();
-        for(auto border : borders) {
+        const auto &borders = tileItem.borderIndices();
+        for(const auto &border : borders) {
             Normal prevNormal;
             Normal firstNormal;
             bool firstNormalSet = false;
@@ -1013,11 +1074,11 @@ bool GlRasterLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
 {
     if(!(m_visible && tile->getTile().z > m_minZoom && tile->getTile().z < m_maxZoom)) {
         MutexHolder holder(m_dataMutex, LOCK_TIME);
-        m_tiles[tile->getTile()] = GlObjectPtr();
+        m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
         return true;
     }
 
-    if(m_tiles.find(tile->getTile()) != m_tiles.end()) { // Already filled
+    if(m_tiles.find(ngsTileKey(tile->getTile())) != m_tiles.end()) { // Already filled
         return true;
     }
 
@@ -1045,7 +1106,7 @@ bool GlRasterLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
         CPLDebug("ngstore", "fill layer %s not intersect - x: %f, y: %f",
                  m_raster->name().c_str(), rasterExtent.minX(), rasterExtent.minY());
         MutexHolder holder(m_dataMutex, LOCK_TIME);
-        m_tiles[tile->getTile()] = GlObjectPtr();
+        m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
         return true;
     }
 
@@ -1148,7 +1209,7 @@ bool GlRasterLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
 
             if(isLastTry) {
                 MutexHolder holder(m_dataMutex, LOCK_TIME);
-                m_tiles[tile->getTile()] = GlObjectPtr();
+                m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
                 return true;
             }
 
@@ -1164,7 +1225,7 @@ bool GlRasterLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
 
             if(isLastTry) {
                 MutexHolder holder(m_dataMutex, LOCK_TIME);
-                m_tiles[tile->getTile()] = GlObjectPtr();
+                m_tiles[ngsTileKey(tile->getTile())] = GlObjectPtr();
                 return true;
             }
 
@@ -1208,7 +1269,7 @@ bool GlRasterLayer::fill(const GlTilePtr &tile, float z, bool isLastTry)
     GlObjectPtr tileData(new RasterGlObject(tileExtentBuff, image));
 
     MutexHolder holder(m_dataMutex, LOCK_TIME);
-    m_tiles[tile->getTile()] = tileData;
+    m_tiles[ngsTileKey(tile->getTile())] = tileData;
 
     return true;
 }
@@ -1223,7 +1284,7 @@ bool GlRasterLayer::draw(const GlTilePtr &tile)
     }
 
     m_dataMutex.acquire(LOCK_TIME);
-    auto tileDataIt = m_tiles.find(tile->getTile());
+    auto tileDataIt = m_tiles.find(ngsTileKey(tile->getTile()));
     if(tileDataIt == m_tiles.end()) {
         m_dataMutex.release();
         return false; // Data not yet loaded
@@ -1329,6 +1390,7 @@ bool GlRasterLayer::setStyleName(const std::string &name)
     if(newStyle) {
         m_oldStyles.push_back(m_style);
         m_style = newStyle;
+        updateGeneration();
     }
     return true;
 }
@@ -1367,9 +1429,18 @@ CPLJSONObject GlRasterLayer::save(const ObjectContainer *objectContainer) const
     return out;
 }
 
+void GlRasterLayer::setVisible(bool visible)
+{
+    if(m_visible != visible) {
+        updateGeneration();
+    }
+    RasterLayer::setVisible(visible);
+}
+
 void GlRasterLayer::setRaster(const RasterPtr &raster)
 {
     RasterLayer::setRaster(raster);
+    updateGeneration();
     // Create default style
     GlView *mapView = dynamic_cast<GlView*>(m_map);
     m_style = StylePtr(Style::createStyle("simpleImage", mapView->textureAtlas()));
@@ -1409,6 +1480,13 @@ void RasterGlObject::destroy()
     m_image->destroy();
 }
 
+size_t RasterGlObject::dataSize() const
+{
+    // RGBA image
+    return m_extentBuffer->dataSize() +
+            m_image->width() * m_image->height() * 4;
+}
+
 //------------------------------------------------------------------------------
 // VectorGlObject
 //------------------------------------------------------------------------------
@@ -1444,6 +1522,15 @@ void VectorGlObject::destroy()
     }
 }
 
+size_t VectorGlObject::dataSize() const
+{
+    size_t size = 0;
+    for(const GlBufferPtr &buffer : m_buffers) {
+        size += buffer->dataSize();
+    }
+    return size;
+}
+
 //------------------------------------------------------------------------------
 // VectorGlObject
 //------------------------------------------------------------------------------
@@ -1496,4 +1583,13 @@ void VectorSelectableGlObject::destroy()
     m_bound = false;
 }
 
+size_t VectorSelectableGlObject::dataSize() const
+{
+    size_t size = VectorGlObject::dataSize();
+    for(const GlBufferPtr &buffer : m_selectionBuffers) {
+        size += buffer->dataSize();
+    }
+    return size;
+}
+
 } // namespace ngs
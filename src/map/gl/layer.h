@@ -22,6 +22,7 @@
 #define NGSGLMAPLAYER_H
 
 #include <set>
+#include <unordered_map>
 
 #include "style.h"
 #include "tile.h"
@@ -47,6 +48,18 @@ public:
      * @param tile Tile to free data
      */
     virtual void free(const GlTilePtr &tile);
+    /**
+     * @brief hasTileData Check if data for tile is already loaded.
+     * @param tile Tile to check
+     * @return True if fill for tile finished.
+     */
+    bool hasTileData(const Tile &tile);
+    /**
+     * @brief tileDataSize Approximate memory size of loaded tile data.
+     * @param tile Tile to check
+     * @return Size in bytes, 0 if no data loaded.
+     */
+    size_t tileDataSize(const Tile &tile);
     /**
      * @brief draw Draw data for specific tile. Run from Gl context.
      * @param tile Tile to draw
@@ -58,11 +71,19 @@ public:
     virtual CPLJSONObject style() const override;
     virtual std::string styleName() const override;
     virtual bool setStyle(const CPLJSONObject &style) override;
+    /**
+     * @brief generation Counter of layer changes which make rendered tiles out
+     * of date.
+     */
+    GUIntBig generation() const { return m_generation; }
+protected:
+    void updateGeneration() { m_generation++; }
 protected:
-    std::map<Tile, GlObjectPtr> m_tiles;
+    std::unordered_map<TileKey, GlObjectPtr> m_tiles;
     StylePtr m_style;
     Mutex m_dataMutex;
     std::vector<StylePtr> m_oldStyles;
+    GUIntBig m_generation;
 };
 
 /**
@@ -80,6 +101,7 @@ public:
     virtual void bind() override;
     virtual void rebind() const override;
     virtual void destroy() override;
+    virtual size_t dataSize() const override;
 protected:
     std::vector<GlBufferPtr> m_buffers;
 };
@@ -100,6 +122,7 @@ public:
     virtual void bind() override;
     virtual void rebind() const override;
     virtual void destroy() override;
+    virtual size_t dataSize() const override;
 
 private:
     std::vector<GlBufferPtr> m_selectionBuffers;
@@ -124,11 +147,17 @@ public:
 public:
     virtual bool load(const CPLJSONObject &store, ObjectContainer *objectContainer) override;
     virtual CPLJSONObject save(const ObjectContainer *objectContainer) const override;
+    virtual void setVisible(bool visible) override;
 
     // FeatureLayer interface
 public:
     virtual void setFeatureClass(const FeatureClassOverviewPtr &featureClass) override;
 
+    // ISelectableFeatureLayer interface
+public:
+    virtual void setSelectedIds(const FeatureIDs &selectedIds) override;
+    virtual void setHideIds(const FeatureIDs &hideIds = FeatureIDs()) override;
+
 protected:
     virtual VectorGlObject *fillPoints(const VectorTile &tile, float z);
     virtual VectorGlObject *fillLines(const VectorTile &tile, float z);
@@ -177,6 +206,7 @@ public:
     virtual void bind() override;
     virtual void rebind() const override;
     virtual void destroy() override;
+    virtual size_t dataSize() const override;
 
 private:
     GlBufferPtr m_extentBuffer;
@@ -201,6 +231,7 @@ public:
 public:
     virtual bool load(const CPLJSONObject &store, ObjectContainer *objectContainer) override;
     virtual CPLJSONObject save(const ObjectContainer *objectContainer) const override;
+    virtual void setVisible(bool visible) override;
 
     // RasterLayer interface
 public:
@@ -1066,6 +1066,22 @@ unsigned short PrimitivePointStyle::addPoint(const SimplePoint &pt, float z,
     return index;
 }
 
+unsigned short PrimitivePointStyle::addScaledPoint(const SimplePoint &pt,
+                                                   float scale, float z,
+                                                   unsigned short index,
+                                                   GlBuffer *buffer)
+{
+    size_t start = buffer->vertexSize();
+    index = addPoint(pt, z, index, buffer);
+
+    // Vertex is x, y, z and normal. Normal is multiplied by size in shader.
+    for(size_t i = start + 3; i + 1 < buffer->vertexSize(); i += 5) {
+        buffer->setVertex(i, buffer->vertex(i) * scale);
+        buffer->setVertex(i + 1, buffer->vertex(i + 1) * scale);
+    }
+    return index;
+}
+
 size_t PrimitivePointStyle::pointVerticesCount() const
 {
     switch(pointType()) {
@@ -137,6 +137,12 @@ public:
     virtual unsigned short addPoint(const SimplePoint &pt, float z,
                                     unsigned short index,
                                     GlBuffer *buffer) = 0;
+    virtual unsigned short addScaledPoint(const SimplePoint &pt, float scale,
+                                          float z, unsigned short index,
+                                          GlBuffer *buffer) {
+        ngsUnused(scale);
+        return addPoint(pt, z, index, buffer);
+    }
     virtual size_t pointVerticesCount() const = 0;
 
     // Style interface
@@ -199,6 +205,9 @@ public:
     virtual unsigned short addPoint(const SimplePoint &pt, float z,
                                     unsigned short index,
                                     GlBuffer *buffer) override;
+    virtual unsigned short addScaledPoint(const SimplePoint &pt, float scale,
+                                          float z, unsigned short index,
+                                          GlBuffer *buffer) override;
     virtual size_t pointVerticesCount() const override;
     virtual enum GlBuffer::BufferType bufferType() const override {
         return GlBuffer::BF_FILL;
@@ -25,11 +25,17 @@
 
 namespace ngs {
 
-GlTile::GlTile(const GlTile other, bool initNew) : GlObject(),
+//------------------------------------------------------------------------------
+// GlTile
+//------------------------------------------------------------------------------
+
+GlTile::GlTile(const GlTile &other, bool initNew) : GlObject(),
     m_tileItem(other.m_tileItem),
     m_id(0),
     m_did(0),
-    m_filled(false)
+    m_filled(false),
+    m_removed(false),
+    m_prefetched(false)
 {
     ngsUnused(initNew);
     m_originalTileSize = other.m_originalTileSize;
@@ -42,7 +48,9 @@ GlTile::GlTile(unsigned short tileSize, const TileItem &tileItem) : GlObject(),
     m_tileItem(tileItem),
     m_id(0),
     m_did(0),
-    m_filled(false)
+    m_filled(false),
+    m_removed(false),
+    m_prefetched(false)
 {
     m_originalTileSize = tileSize;
     m_originalEnv = tileItem.env;
@@ -97,6 +105,16 @@ void GlTile::init(unsigned short tileSize, const Envelope &tileItemEnv,
                                static_cast<float>(resizeOriginal.maxY()),
                                static_cast<float>(DEFAULT_BOUNDS.minX()),
                                static_cast<float>(DEFAULT_BOUNDS.maxX()));
+    // Origin is subtracted in double precision, so the matrix is accurate at
+    // any zoom level.
+    OGRRawPoint origin = ngsTileOrigin(m_tileItem.tile);
+    m_localSceneMatrix = glm::ortho(
+                static_cast<float>(resizeOriginal.minX() - origin.x),
+                static_cast<float>(resizeOriginal.maxX() - origin.x),
+                static_cast<float>(resizeOriginal.minY() - origin.y),
+                static_cast<float>(resizeOriginal.maxY() - origin.y),
+                static_cast<float>(DEFAULT_BOUNDS.minX()),
+                static_cast<float>(DEFAULT_BOUNDS.maxX()));
     m_invViewMatrix = glm::ortho(0.0f, static_cast<float>(newTileSize), 0.0f,
                                  static_cast<float>(newTileSize), -1.0f, 1.0f);
 
@@ -184,4 +202,122 @@ void GlTile::prepareContext()
         //    ngsCheckGLError(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
 }
 
+//------------------------------------------------------------------------------
+// GlTileCache
+//------------------------------------------------------------------------------
+
+GlTileCache::GlTileCache(size_t maxSize) :
+    m_maxSize(maxSize)
+{
+}
+
+/**
+ * @brief GlTileCache::take Removes the tile from cache to put it back in view.
+ * @param tile Tile to find.
+ * @param generation Layers generation the tile was rendered with.
+ * @return Cached tile or empty pointer.
+ */
+GlTilePtr GlTileCache::take(const Tile &tile, GUIntBig &generation)
+{
+    auto it = m_index.find(ngsTileKey(tile));
+    if(it == m_index.end()) {
+        return GlTilePtr();
+    }
+
+    GlTilePtr out = it->second->tile;
+    generation = it->second->generation;
+    m_items.erase(it->second);
+    m_index.erase(it);
+    return out;
+}
+
+/**
+ * @brief GlTileCache::put Adds filled tile to cache.
+ * @param tile Tile to add.
+ * @param generation Layers generation the tile was rendered with.
+ * @return Tiles evicted from cache. Caller should free their Gl objects.
+ */
+std::vector<GlTilePtr> GlTileCache::put(const GlTilePtr &tile,
+                                        GUIntBig generation)
+{
+    std::vector<GlTilePtr> out;
+    auto it = m_index.find(ngsTileKey(tile->getTile()));
+    if(it != m_index.end()) {
+        if(it->second->tile != tile) {
+            out.push_back(it->second->tile);
+        }
+        m_items.erase(it->second);
+        m_index.erase(it);
+    }
+
+    m_items.push_front({tile, generation});
+    m_index[ngsTileKey(tile->getTile())] = m_items.begin();
+
+    while(m_items.size() > m_maxSize) {
+        const CacheItem &last = m_items.back();
+        out.push_back(last.tile);
+        m_index.erase(ngsTileKey(last.tile->getTile()));
+        m_items.pop_back();
+    }
+    return out;
+}
+
+/**
+ * @brief GlTileCache::find Finds the tile without changing its place in cache,
+ * i.e. to draw it as a placeholder.
+ * @param tile Tile to find.
+ * @param generation Current layers generation.
+ * @return Cached tile rendered with the generation or empty pointer.
+ */
+GlTilePtr GlTileCache::find(const Tile &tile, GUIntBig generation) const
+{
+    auto it = m_index.find(ngsTileKey(tile));
+    if(it == m_index.end() || it->second->generation != generation) {
+        return GlTilePtr();
+    }
+    return it->second->tile;
+}
+
+bool GlTileCache::contains(const GlTile *tile) const
+{
+    auto it = m_index.find(ngsTileKey(tile->getTile()));
+    return it != m_index.end() && it->second->tile.get() == tile;
+}
+
+/**
+ * @brief GlTileCache::remove Removes tiles intersecting bounds, i.e. after
+ * features edit.
+ * @param bounds Changed area.
+ * @return Removed tiles. Caller should free their Gl objects.
+ */
+std::vector<GlTilePtr> GlTileCache::remove(const Envelope &bounds)
+{
+    std::vector<GlTilePtr> out;
+    auto it = m_items.begin();
+    while(it != m_items.end()) {
+        Envelope env = it->tile->getExtent();
+        env.resize(TILE_RESIZE);
+        if(env.intersects(bounds)) {
+            out.push_back(it->tile);
+            m_index.erase(ngsTileKey(it->tile->getTile()));
+            it = m_items.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    return out;
+}
+
+std::vector<GlTilePtr> GlTileCache::clear()
+{
+    std::vector<GlTilePtr> out;
+    for(const CacheItem &item : m_items) {
+        out.push_back(item.tile);
+    }
+    m_items.clear();
+    m_index.clear();
+    return out;
+}
+
 } // namespace ngs
@@ -21,6 +21,11 @@
 #ifndef NGSGLTILE_H
 #define NGSGLTILE_H
 
+// stl
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
 #include "buffer.h"
 #include "image.h"
 #include "ds/geometry.h"
@@ -40,10 +45,11 @@ class GlTile : public GlObject
 {
 public:
     explicit GlTile(unsigned short tileSize, const TileItem &tileItem);
-    explicit GlTile(const GlTile other, bool initNew);
+    explicit GlTile(const GlTile &other, bool initNew);
     virtual ~GlTile() override = default;
 
     glm::mat4 getSceneMatrix() const { return m_sceneMatrix; }
+    glm::mat4 getLocalSceneMatrix() const { return m_localSceneMatrix; }
     glm::mat4 getInvViewMatrix() const { return m_invViewMatrix; }
     GlImage *getImageRef() const { return const_cast<GlImage*>(&m_image); }
     const GlBuffer &getBuffer() const { return m_tile; }
@@ -51,6 +57,10 @@ public:
     const Envelope &getExtent() const { return m_tileItem.env; }
     bool filled() const { return m_filled; }
     void setFilled(bool filled = true) { m_filled = filled; }
+    bool removed() const { return m_removed; }
+    void setRemoved(bool removed = true) { m_removed = removed; }
+    bool prefetched() const { return m_prefetched; }
+    void setPrefetched(bool prefetched = true) { m_prefetched = prefetched; }
     size_t getSizeInPixels() const {
         return size_t(m_originalTileSize);///*m_image.getWidth()*/ * 256.0 / GLTILE_SIZE);
     }
@@ -74,14 +84,51 @@ protected:
     GLuint m_id, m_did;
     GlBuffer m_tile;
     glm::mat4 m_sceneMatrix;
+    // Scene matrix for vector tile items relative to the tile origin
+    glm::mat4 m_localSceneMatrix;
     glm::mat4 m_invViewMatrix;
     bool m_filled;
+    // Tile is out of view, its pending fill jobs are skipped
+    std::atomic<bool> m_removed;
+    // Tile is filled ahead of view, layers with loaded data are not refilled
+    std::atomic<bool> m_prefetched;
     unsigned short m_tileSize, m_originalTileSize;
     Envelope m_originalEnv;
 };
 
 typedef std::shared_ptr<GlTile> GlTilePtr;
 
+/**
+ * @brief The GlTileCache class. Size bounded LRU cache of filled tiles scrolled
+ * out of view. Cached tile is valid only for the layers generation it was
+ * rendered with. Run from Gl context.
+ */
+class GlTileCache
+{
+public:
+    explicit GlTileCache(size_t maxSize);
+    GlTilePtr take(const Tile &tile, GUIntBig &generation);
+    GlTilePtr find(const Tile &tile, GUIntBig generation) const;
+    std::vector<GlTilePtr> put(const GlTilePtr &tile, GUIntBig generation);
+    bool contains(const GlTile *tile) const;
+    std::vector<GlTilePtr> remove(const Envelope &bounds);
+    std::vector<GlTilePtr> clear();
+    size_t size() const { return m_items.size(); }
+    size_t maxSize() const { return m_maxSize; }
+
+private:
+    struct CacheItem {
+        GlTilePtr tile;
+        GUIntBig generation;
+    };
+    using CacheItems = std::list<CacheItem>;
+
+private:
+    CacheItems m_items;
+    std::unordered_map<TileKey, CacheItems::iterator> m_index;
+    size_t m_maxSize;
+};
+
 } // namespace ngs
 
 #endif // NGSGLTILE_H
@@ -21,6 +21,10 @@
 
 #include "view.h"
 
+// stl
+#include <set>
+#include <unordered_set>
+
 #include "ds/featureclassovr.h"
 #include "layer.h"
 #include "style.h"
@@ -31,7 +35,23 @@
 namespace ngs {
 
 constexpr unsigned char MAX_TRIES = 2;
+// Fill jobs of hidden layers go after all jobs of visible layers
+constexpr double HIDDEN_LAYER_FILL_PRIORITY = 1000000.0;
 constexpr const char* SELECTION_KEY = "selection";
+// Filled tiles out of view kept to draw at once on pan or zoom back are
+// limited by texture memory. Each tile holds RGBA color and 16 bit depth
+// buffers of the tile size resized by TILE_RESIZE, about 1.9 Mb for 512 px.
+constexpr size_t MAX_CACHED_TILES_MEMORY = 32 * 1024 * 1024;
+constexpr size_t CACHED_TILE_SIDE =
+        static_cast<size_t>(GLTILE_SIZE * TILE_RESIZE) + 1;
+constexpr size_t MAX_CACHED_TILES = MAX_CACHED_TILES_MEMORY /
+        (CACHED_TILE_SIDE * CACHED_TILE_SIDE * 6);
+// How many zoom levels up to look for a placeholder of not filled tile
+constexpr int MAX_PLACEHOLDER_ZOOM_UP = 3;
+// Fill jobs of prefetch tiles go after all jobs of tiles in view
+constexpr double PREFETCH_FILL_PRIORITY = 1000.0;
+// Layers data of prefetch tiles is kept till they come into view
+constexpr size_t DEFAULT_PREFETCH_MEMORY = 32 * 1024 * 1024;
 
 //------------------------------------------------------------------------------
 // LayerFillData
@@ -52,21 +72,38 @@ public:
 //------------------------------------------------------------------------------
 
 
-GlView::GlView() : MapView()
+GlView::GlView() : MapView(),
+    m_tileCache(MAX_CACHED_TILES),
+    m_layersGeneration(0),
+    m_prefetchTileCount(0),
+    m_prefetchMemory(DEFAULT_PREFETCH_MEMORY),
+    m_prefetchGeneration(0),
+    m_lastZoom(0),
+    m_prefetchZoomStep(0)
 {
     initView();
 }
 
 GlView::GlView(const std::string &name, const std::string &description,
                unsigned short epsg, const Envelope &bounds) :
-    MapView(name, description, epsg, bounds)
+    MapView(name, description, epsg, bounds),
+    m_tileCache(MAX_CACHED_TILES),
+    m_layersGeneration(0),
+    m_prefetchTileCount(0),
+    m_prefetchMemory(DEFAULT_PREFETCH_MEMORY),
+    m_prefetchGeneration(0),
+    m_lastZoom(0),
+    m_prefetchZoomStep(0)
 {
     initView();
 }
 
 void GlView::clearTiles()
 {
-    std::for_each(m_tiles.begin(), m_tiles.end(), [](GlTilePtr &tile){ tile->destroy(); });
+    std::for_each(m_tiles.begin(), m_tiles.end(), [](GlTilePtr &tile){
+        tile->setRemoved();
+        tile->destroy();
+    });
     m_tiles.clear();
 }
 
@@ -81,6 +118,11 @@ void GlView::setBackgroundColor(const ngsRGBA &color)
 
 bool GlView::close()
 {
+    for(const GlTilePtr &tile : m_prefetchTiles) {
+        discardPrefetchTile(tile);
+    }
+    m_prefetchTiles.clear();
+    releaseTiles(m_tileCache.clear());
     freeOldTiles();
     freeResources();
     clearTiles();
@@ -109,6 +151,29 @@ bool GlView::setSelectionStyleName(enum ngsStyleType styleType, const std::strin
     return false;
 }
 
+int GlView::createLayer(const std::string &name, const ObjectPtr &object)
+{
+    m_layersGeneration++;
+    return MapView::createLayer(name, object);
+}
+
+bool GlView::deleteLayer(Layer *layer)
+{
+    // Keep the deleted layer counter, so the tiles generation never goes back
+    GlRenderLayer *renderLayer = dynamic_cast<GlRenderLayer*>(layer);
+    if(renderLayer) {
+        m_layersGeneration += renderLayer->generation();
+    }
+    m_layersGeneration++;
+    return MapView::deleteLayer(layer);
+}
+
+bool GlView::reorderLayers(Layer *beforeLayer, Layer *movedLayer)
+{
+    m_layersGeneration++;
+    return MapView::reorderLayers(beforeLayer, movedLayer);
+}
+
 LayerPtr GlView::createLayer(const std::string &name, Layer::Type type)
 {
     switch (type) {
@@ -125,8 +190,17 @@ bool GlView::layerDataFillJobThreadFunc(ThreadData* threadData)
 {
     LayerFillData *layerData = dynamic_cast<LayerFillData*>(threadData);
     if (nullptr != layerData) {
+        // Tile scrolled out of view while the job was queued
+        if(layerData->m_tile->removed()) {
+            return true;
+        }
         GlRenderLayer *renderLayer = ngsDynamicCast(GlRenderLayer,layerData->m_layer);
         if (nullptr != renderLayer) {
+            // Layer data is loaded by prefetch
+            if(layerData->m_tile->prefetched() &&
+                    renderLayer->hasTileData(layerData->m_tile->getTile())) {
+                return true;
+            }
             return renderLayer->fill(layerData->m_tile, layerData->m_zlevel,
                                      layerData->tries() >= MAX_TRIES);
         }
@@ -170,6 +244,11 @@ bool GlView::draw(ngsDrawState state, const Progress &progress)
     case DS_REDRAW:
         clearTiles();
     [[clang::fallthrough]]; case DS_REFILL:
+        releaseTiles(m_tileCache.clear());
+        for(const GlTilePtr &tile : m_prefetchTiles) {
+            discardPrefetchTile(tile);
+        }
+        m_prefetchTiles.clear();
         for(GlTilePtr& tile : m_tiles) {
             tile->setFilled(false);
         }
@@ -181,15 +260,9 @@ bool GlView::draw(ngsDrawState state, const Progress &progress)
         for(const GlTilePtr& tile : m_tiles) {
             if(tile->filled())
                 continue;
-            float z = 0.0f;
-            for(auto layerIt = m_layers.rbegin(); layerIt != m_layers.rend();
-                 ++layerIt) {
-                const LayerPtr &layer = *layerIt;
-                m_threadPool.addThreadData(new LayerFillData(tile, layer, z, true));
-
-                z += 1000.0f;
-            }
+            queueFill(tile);
         }
+        queuePrefetch();
     [[clang::fallthrough]]; case DS_PRESERVED:
         bool result = drawTiles(progress);
         // Free unnecessary Gl objects as this call is in Gl context
@@ -210,6 +283,7 @@ void GlView::invalidate(const Envelope &bounds)
          Envelope env = tile->getExtent();
          env.resize(TILE_RESIZE);
          if(env.intersects(bounds) || env.intersects(m_invalidRegion)) {
+             tile->setRemoved();
              m_oldTiles.push_back(tile);
              it = m_tiles.erase(it);
 
@@ -222,18 +296,242 @@ void GlView::invalidate(const Envelope &bounds)
 
     for(const GlTilePtr &tile : newTiles) {
         m_tiles.push_back(tile);
-        float z = 0.0f;
-        for (auto layerIt = m_layers.rbegin(); layerIt != m_layers.rend();
-             ++layerIt) {
-            const LayerPtr &layer = *layerIt;
-            m_threadPool.addThreadData(new LayerFillData(tile, layer, z, true));
-            z += 1000.f;
+        queueFill(tile);
+    }
+
+    releaseTiles(m_tileCache.remove(bounds));
+
+    // Drop prefetched data of the changed area, it is freed with old tiles
+    auto prefetchIt = m_prefetchTiles.begin();
+    while(prefetchIt != m_prefetchTiles.end()) {
+        Envelope env = (*prefetchIt)->getExtent();
+        env.resize(TILE_RESIZE);
+        if(env.intersects(bounds)) {
+            (*prefetchIt)->setRemoved();
+            m_oldTiles.push_back(*prefetchIt);
+            prefetchIt = m_prefetchTiles.erase(prefetchIt);
+        }
+        else {
+            ++prefetchIt;
         }
     }
 
     m_invalidRegion = bounds;
 }
 
+/**
+ * @brief GlView::queueFill Adds fill jobs of all layers for the tile. Jobs are
+ * ordered by distance from the view center to the tile center in tile sizes,
+ * so tiles in the middle of the screen are filled first. Jobs of hidden
+ * layers go last.
+ * @param tile Tile to fill.
+ * @param priority Value added to the jobs priority.
+ */
+void GlView::queueFill(const GlTilePtr &tile, double priority)
+{
+    Envelope env = tile->getExtent();
+    env.move(tile->getTile().crossExtent * DEFAULT_BOUNDS.width(), 0.0);
+    double distance = priority +
+            ngsDistance(getCenter(), env.center()) / env.width();
+
+    float z = 0.0f;
+    for(auto layerIt = m_layers.rbegin(); layerIt != m_layers.rend();
+         ++layerIt) {
+        const LayerPtr &layer = *layerIt;
+        LayerFillData *data = new LayerFillData(tile, layer, z, true);
+        data->setPriority(layer->visible() ? distance :
+                                             distance + HIDDEN_LAYER_FILL_PRIORITY);
+        m_threadPool.addThreadData(data);
+        z += 1000.0f;
+    }
+}
+
+/**
+ * @brief GlView::queuePrefetch Fills tiles ahead of view. The last pan shift
+ * gives the ring of tiles in the pan direction, the last zoom change gives the
+ * next zoom level tiles under the viewport. The number of prefetch tiles is
+ * limited by PREFETCH_TILES option and their layers data by PREFETCH_MEMORY
+ * option. Data of filled tiles is measured, not filled tiles are estimated by
+ * the average of filled ones. Prefetch jobs go after jobs of tiles in view.
+ * Prefetch tiles which are not needed any more are discarded with their data.
+ */
+void GlView::queuePrefetch()
+{
+    OGRRawPoint center = getCenter();
+    unsigned char zoom = getZoom();
+    if(zoom != m_lastZoom) {
+        m_prefetchZoomStep = zoom > m_lastZoom ? 1 : -1;
+        m_prefetchShift = OGRRawPoint();
+    }
+    else if(!isEqual(center.x, m_lastCenter.x) ||
+            !isEqual(center.y, m_lastCenter.y)) {
+        m_prefetchZoomStep = 0;
+        m_prefetchShift = OGRRawPoint(center.x - m_lastCenter.x,
+                                      center.y - m_lastCenter.y);
+    }
+    m_lastCenter = center;
+    m_lastZoom = zoom;
+
+    GUIntBig generation = tilesGeneration();
+    if(m_prefetchTileCount == 0 || generation != m_prefetchGeneration) {
+        for(const GlTilePtr &tile : m_prefetchTiles) {
+            discardPrefetchTile(tile);
+        }
+        m_prefetchTiles.clear();
+        m_prefetchGeneration = generation;
+    }
+
+    if(m_prefetchTileCount == 0) {
+        return;
+    }
+
+    Envelope ext = getExtent();
+    ext.resize(TILE_RESIZE);
+    std::vector<TileItem> tileItems;
+    if(m_prefetchZoomStep != 0) {
+        int prefetchZoom = zoom + m_prefetchZoomStep;
+        if(prefetchZoom >= 0) {
+            tileItems = getTilesForExtent(ext,
+                                          static_cast<unsigned char>(prefetchZoom),
+                                          false, getXAxisLooped());
+        }
+    }
+    else if(!isEqual(m_prefetchShift.x, 0.0) ||
+            !isEqual(m_prefetchShift.y, 0.0)) {
+        double tileSize = DEFAULT_BOUNDS.width() / (1 << zoom);
+        double shiftX = isEqual(m_prefetchShift.x, 0.0) ? 0.0 :
+            (m_prefetchShift.x > 0.0 ? tileSize : -tileSize);
+        double shiftY = isEqual(m_prefetchShift.y, 0.0) ? 0.0 :
+            (m_prefetchShift.y > 0.0 ? tileSize : -tileSize);
+        ext.move(shiftX, shiftY);
+        tileItems = getTilesForExtent(ext, zoom, false, getXAxisLooped());
+    }
+
+    // Skip tiles in view and rendered tiles in cache
+    std::unordered_set<TileKey> viewKeys;
+    viewKeys.reserve(m_tiles.size());
+    for(const GlTilePtr &tile : m_tiles) {
+        viewKeys.insert(ngsTileKey(tile->getTile()));
+    }
+    tileItems.erase(std::remove_if(tileItems.begin(), tileItems.end(),
+                                   [this, &viewKeys, generation](const TileItem &item) {
+        return viewKeys.find(ngsTileKey(item.tile)) != viewKeys.end() ||
+                m_tileCache.find(item.tile, generation);
+    }), tileItems.end());
+
+    // Nearest to the view center first
+    std::sort(tileItems.begin(), tileItems.end(),
+              [&center](const TileItem &a, const TileItem &b) {
+        Envelope envA = a.env, envB = b.env;
+        envA.move(a.tile.crossExtent * DEFAULT_BOUNDS.width(), 0.0);
+        envB.move(b.tile.crossExtent * DEFAULT_BOUNDS.width(), 0.0);
+        return ngsDistance(center, envA.center()) <
+                ngsDistance(center, envB.center());
+    });
+    if(tileItems.size() > m_prefetchTileCount) {
+        tileItems.resize(m_prefetchTileCount);
+    }
+
+    if(m_prefetchMemory > 0) {
+        std::unordered_map<TileKey, size_t> dataSizes;
+        size_t filledSize = 0;
+        for(const GlTilePtr &tile : m_prefetchTiles) {
+            size_t size = tileDataSize(tile);
+            if(size > 0) {
+                dataSizes[ngsTileKey(tile->getTile())] = size;
+                filledSize += size;
+            }
+        }
+        size_t averageSize = dataSizes.empty() ? 0 :
+                                                 filledSize / dataSizes.size();
+
+        size_t memory = 0;
+        size_t count = 0;
+        for(const TileItem &tileItem : tileItems) {
+            auto it = dataSizes.find(ngsTileKey(tileItem.tile));
+            memory += it != dataSizes.end() ? it->second : averageSize;
+            if(memory > m_prefetchMemory) {
+                break;
+            }
+            count++;
+        }
+        tileItems.resize(count);
+    }
+
+    std::vector<GlTilePtr> prefetchTiles;
+    for(const TileItem &tileItem : tileItems) {
+        auto prefetchIt = std::find_if(m_prefetchTiles.begin(),
+                                       m_prefetchTiles.end(),
+                                       [&tileItem](const GlTilePtr &prefetchTile) {
+            return prefetchTile->getTile() == tileItem.tile;
+        });
+        if(prefetchIt != m_prefetchTiles.end()) {
+            prefetchTiles.push_back(*prefetchIt);
+            m_prefetchTiles.erase(prefetchIt);
+        }
+        else {
+            GlTilePtr tile(new GlTile(GLTILE_SIZE, tileItem));
+            tile->setPrefetched();
+            prefetchTiles.push_back(tile);
+        }
+    }
+
+    for(const GlTilePtr &tile : m_prefetchTiles) {
+        discardPrefetchTile(tile);
+    }
+    m_prefetchTiles = prefetchTiles;
+
+    for(const GlTilePtr &tile : m_prefetchTiles) {
+        queueFill(tile, PREFETCH_FILL_PRIORITY);
+    }
+}
+
+/**
+ * @brief GlView::discardPrefetchTile Frees data of unused prefetch tile.
+ * @param tile Tile to discard.
+ */
+void GlView::discardPrefetchTile(const GlTilePtr &tile)
+{
+    tile->setRemoved();
+    // Data of the same tile in view is kept
+    bool inView = std::find_if(m_tiles.begin(), m_tiles.end(),
+                               [&tile](const GlTilePtr &viewTile) {
+        return viewTile->getTile() == tile->getTile();
+    }) != m_tiles.end();
+    if(!inView) {
+        freeLayersData(tile);
+    }
+    freeResource(std::dynamic_pointer_cast<GlObject>(tile));
+}
+
+/**
+ * @brief GlView::tileDataSize Returns memory size of all layers data of tile.
+ * @param tile Tile to check.
+ * @return Size in bytes.
+ */
+size_t GlView::tileDataSize(const GlTilePtr &tile) const
+{
+    size_t size = 0;
+    for(const LayerPtr &layer : m_layers) {
+        GlRenderLayer *renderLayer = ngsDynamicCast(GlRenderLayer, layer);
+        if(renderLayer) {
+            size += renderLayer->tileDataSize(tile->getTile());
+        }
+    }
+    return size;
+}
+
+bool GlView::setOptions(const Options &options)
+{
+    m_prefetchTileCount = static_cast<size_t>(
+                std::max(0, options.asInt("PREFETCH_TILES", 0)));
+    m_prefetchMemory = static_cast<size_t>(std::max(0.0,
+                options.asDouble("PREFETCH_MEMORY",
+                                 DEFAULT_PREFETCH_MEMORY / 1048576.0)) *
+                1048576.0);
+    return MapView::setOptions(options);
+}
+
 bool GlView::setSelectionStyle(enum ngsStyleType styleType,
                                const CPLJSONObject &style)
 {
@@ -344,33 +642,87 @@ void GlView::updateTilesList()
     std::vector<TileItem> tileItems = getTilesForExtent(ext, getZoom(), false, // False mean that we use OSM/Google tile scheme in map. Not connected with getYAxisInverted()
                                                         getXAxisLooped());
 
+    GUIntBig generation = tilesGeneration();
+
+    // Diff Gl tiles and tiles for extent by packed tile keys
+    std::unordered_set<TileKey> extentKeys;
+    extentKeys.reserve(tileItems.size());
+    for(const TileItem &tileItem : tileItems) {
+        extentKeys.insert(ngsTileKey(tileItem.tile));
+    }
+
     // Remove out of extent Gl tiles
-    auto tileIt = m_tiles.begin();
-    while(tileIt != m_tiles.end()) {
-        bool markToDelete = true;
-        auto itemIt = tileItems.begin();
-        while(itemIt != tileItems.end()) {
-            if((*tileIt)->getTile() == (*itemIt).tile) {
-                // Item already present in m_tiles
-                tileItems.erase(itemIt);
-                markToDelete = false;
-                break;
-            }
-            ++itemIt;
+    std::unordered_set<TileKey> presentKeys;
+    presentKeys.reserve(m_tiles.size());
+    std::vector<GlTilePtr> tiles;
+    tiles.reserve(tileItems.size());
+    for(const GlTilePtr &tile : m_tiles) {
+        TileKey key = ngsTileKey(tile->getTile());
+        if(extentKeys.find(key) != extentKeys.end()) {
+            presentKeys.insert(key);
+            tiles.push_back(tile);
+            continue;
         }
 
-        if(markToDelete) {
-            m_oldTiles.push_back(*tileIt);
-            tileIt = m_tiles.erase(tileIt);
-        }
-        else {
-            ++tileIt;
+        tile->setRemoved();
+        m_oldTiles.push_back(tile);
+        if(tile->filled()) {
+            releaseTiles(m_tileCache.put(tile, generation));
         }
     }
+    m_tiles.swap(tiles);
 
-    // Add new Gl tiles
+    // Add new Gl tiles. Tiles rendered with the same layers state are taken
+    // from cache and need no fill.
+    std::vector<TileItem> newTileItems;
     for(const TileItem &tileItem : tileItems) {
+        if(presentKeys.find(ngsTileKey(tileItem.tile)) != presentKeys.end()) {
+            continue;
+        }
+
+        GUIntBig cachedGeneration = 0;
+        GlTilePtr tile = m_tileCache.take(tileItem.tile, cachedGeneration);
+        if(tile && cachedGeneration == generation) {
+            tile->setRemoved(false);
+            m_oldTiles.erase(std::remove(m_oldTiles.begin(), m_oldTiles.end(),
+                                         tile), m_oldTiles.end());
+            m_tiles.push_back(tile);
+            continue;
+        }
+
+        if(tile) {
+            releaseTiles({tile});
+        }
+
+        // Prefetched tile keeps data loaded ahead
+        auto prefetchIt = std::find_if(m_prefetchTiles.begin(),
+                                       m_prefetchTiles.end(),
+                                       [&tileItem](const GlTilePtr &prefetchTile) {
+            return prefetchTile->getTile() == tileItem.tile;
+        });
+        if(prefetchIt != m_prefetchTiles.end()) {
+            m_tiles.push_back(*prefetchIt);
+            m_prefetchTiles.erase(prefetchIt);
+            continue;
+        }
+
         m_tiles.push_back(GlTilePtr(new GlTile(GLTILE_SIZE, tileItem)));
+        newTileItems.push_back(tileItem);
+    }
+
+    // Read stored overview tiles for new Gl tiles with one query per layer
+    if(!newTileItems.empty()) {
+        for(const LayerPtr &layer : m_layers) {
+            if(!layer->visible()) {
+                continue;
+            }
+            FeatureClassOverviewPtr featureClass =
+                    std::dynamic_pointer_cast<FeatureClassOverview>(
+                        layer->datasource());
+            if(featureClass) {
+                featureClass->cacheTiles(newTileItems);
+            }
+        }
     }
 
 //    CPLDebug("ngstore", "Tile count: %ld", m_tiles.size());
@@ -391,6 +743,7 @@ bool GlView::drawTiles(const Progress &progress)
     ngsCheckGLError(glDisable(GL_BLEND));
 
     drawOldTiles();
+    drawPlaceholders();
 
     // Preserve current viewport
     GLint viewport[4];
@@ -469,10 +822,7 @@ bool GlView::drawTiles(const Progress &progress)
         }
 
         if(drawTile) { // Don't draw tiles with only background
-            m_fboDrawStyle.setImage(tile->getImageRef());
-            tile->getBuffer().rebind();
-            m_fboDrawStyle.prepare(getSceneMatrix(), getInvViewMatrix(), tile->getBuffer().type());
-            m_fboDrawStyle.draw(tile->getBuffer());
+            drawTileImage(tile);
         }
     }
 
@@ -505,30 +855,124 @@ void GlView::drawOldTiles()
 {
     for(const GlTilePtr &oldTile : m_oldTiles) {
         if(oldTile->filled()){
-            m_fboDrawStyle.setImage(oldTile->getImageRef());
-            oldTile->getBuffer().rebind();
-            m_fboDrawStyle.prepare(getSceneMatrix(), getInvViewMatrix(),
-                                   oldTile->getBuffer().type());
-            m_fboDrawStyle.draw(oldTile->getBuffer());
+            drawTileImage(oldTile);
+        }
+    }
+}
+
+/**
+ * @brief GlView::drawPlaceholders Draws cached tiles of other zoom levels in
+ * place of not filled tiles: the nearest ancestor scaled up and child tiles
+ * scaled down over it. Tile buffers are in map coordinates, so scene matrix
+ * does the scaling. Exact tiles are drawn over placeholders when filled.
+ */
+void GlView::drawPlaceholders()
+{
+    GUIntBig generation = tilesGeneration();
+    std::set<const GlTile*> drawn;
+    auto drawPlaceholder = [this, &drawn](const GlTilePtr &placeholder) {
+        if(placeholder && drawn.insert(placeholder.get()).second) {
+            drawTileImage(placeholder);
+        }
+    };
+
+    for(const GlTilePtr &tile : m_tiles) {
+        if(tile->filled()) {
+            continue;
+        }
+
+        const Tile &current = tile->getTile();
+        for(int up = 1; up <= MAX_PLACEHOLDER_ZOOM_UP && up <= current.z; ++up) {
+            Tile parent = {current.x >> up, current.y >> up,
+                           static_cast<unsigned char>(current.z - up),
+                           current.crossExtent};
+            GlTilePtr placeholder = m_tileCache.find(parent, generation);
+            if(placeholder) {
+                drawPlaceholder(placeholder);
+                break;
+            }
+        }
+
+        for(int i = 0; i < 4; ++i) {
+            Tile child = {current.x * 2 + i % 2, current.y * 2 + i / 2,
+                          static_cast<unsigned char>(current.z + 1),
+                          current.crossExtent};
+            drawPlaceholder(m_tileCache.find(child, generation));
         }
     }
 }
 
+void GlView::drawTileImage(const GlTilePtr &tile)
+{
+    m_fboDrawStyle.setImage(tile->getImageRef());
+    tile->getBuffer().rebind();
+    m_fboDrawStyle.prepare(getSceneMatrix(), getInvViewMatrix(),
+                           tile->getBuffer().type());
+    m_fboDrawStyle.draw(tile->getBuffer());
+}
+
 void GlView::freeOldTiles()
 {
     for(const GlTilePtr &oldTile : m_oldTiles) {
-        for(const LayerPtr &layer : m_layers) {
-            GlRenderLayer *renderLayer = ngsDynamicCast(GlRenderLayer, layer);
-            if(renderLayer) {
-                renderLayer->free(oldTile);
-            }
+        // Keep Gl objects of cached tiles
+        if(m_tileCache.contains(oldTile.get())) {
+            continue;
         }
 
+        freeLayersData(oldTile);
         freeResource(std::dynamic_pointer_cast<GlObject>(oldTile));
     }
     m_oldTiles.clear();
 }
 
+/**
+ * @brief GlView::freeLayersData Frees data of all render layers for the tile.
+ * @param tile Tile to free layers data.
+ */
+void GlView::freeLayersData(const GlTilePtr &tile)
+{
+    for(const LayerPtr &layer : m_layers) {
+        GlRenderLayer *renderLayer = ngsDynamicCast(GlRenderLayer, layer);
+        if(renderLayer) {
+            renderLayer->free(tile);
+        }
+    }
+}
+
+/**
+ * @brief GlView::releaseTiles Frees layers data and Gl objects of tiles dropped
+ * from cache. Tiles still drawn as old tiles are freed in freeOldTiles.
+ * @param tiles Tiles to free.
+ */
+void GlView::releaseTiles(const std::vector<GlTilePtr> &tiles)
+{
+    for(const GlTilePtr &tile : tiles) {
+        if(std::find(m_oldTiles.begin(), m_oldTiles.end(), tile) ==
+                m_oldTiles.end()) {
+            freeLayersData(tile);
+            freeResource(std::dynamic_pointer_cast<GlObject>(tile));
+        }
+    }
+}
+
+/**
+ * @brief GlView::tilesGeneration Returns the layers state the tiles are
+ * rendered with. All counters only grow and the view counter takes over the
+ * counter of deleted layer, so the sum grows on any layer change.
+ * @return Layers generation.
+ */
+GUIntBig GlView::tilesGeneration() const
+{
+    GUIntBig out = m_layersGeneration;
+    for(const LayerPtr &layer : m_layers) {
+        GlRenderLayer *renderLayer = ngsDynamicCast(GlRenderLayer, layer);
+        if(renderLayer) {
+            out += renderLayer->generation();
+        }
+    }
+    return out;
+}
+
 void GlView::initView()
 {
     m_selectionStyles[ST_POINT] = StylePtr(Style::createStyle("primitivePoint", m_textureAtlas));
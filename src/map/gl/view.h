@@ -52,10 +52,19 @@ public:
 protected:
     void clearTiles();
     void updateTilesList();
+    void queueFill(const GlTilePtr &tile, double priority = 0.0);
+    void queuePrefetch();
+    void discardPrefetchTile(const GlTilePtr &tile);
+    size_t tileDataSize(const GlTilePtr &tile) const;
     void freeResources();
     bool drawTiles(const Progress &progress);
     void drawOldTiles();
+    void drawPlaceholders();
+    void drawTileImage(const GlTilePtr &tile);
     void freeOldTiles();
+    void freeLayersData(const GlTilePtr &tile);
+    void releaseTiles(const std::vector<GlTilePtr> &tiles);
+    GUIntBig tilesGeneration() const;
     void initView();
     double pixelSize(int zoom);
 
@@ -63,6 +72,10 @@ protected:
 public:
     virtual void setBackgroundColor(const ngsRGBA &color) override;
     virtual bool close() override;
+    virtual int createLayer(const std::string &name,
+                            const ObjectPtr &object) override;
+    virtual bool deleteLayer(Layer *layer) override;
+    virtual bool reorderLayers(Layer *beforeLayer, Layer *movedLayer) override;
 
     // Map interface
 protected:
@@ -75,6 +88,7 @@ protected:
 public:
     virtual bool draw(ngsDrawState state, const Progress &progress) override;
     virtual void invalidate(const Envelope& bounds) override;
+    virtual bool setOptions(const Options &options) override;
     virtual bool setSelectionStyleName(enum ngsStyleType styleType,
                                        const std::string &name) override;
     virtual bool setSelectionStyle(enum ngsStyleType styleType,
@@ -111,6 +125,15 @@ private:
     GlColor m_glBkColor;
     std::vector<GlObjectPtr> m_freeResources;
     std::vector<GlTilePtr> m_tiles, m_oldTiles;
+    GlTileCache m_tileCache;
+    GUIntBig m_layersGeneration;
+    std::vector<GlTilePtr> m_prefetchTiles;
+    size_t m_prefetchTileCount;
+    size_t m_prefetchMemory;
+    GUIntBig m_prefetchGeneration;
+    OGRRawPoint m_lastCenter, m_prefetchShift;
+    unsigned char m_lastZoom;
+    int m_prefetchZoomStep;
     TextureAtlas m_textureAtlas;
     Envelope m_invalidRegion;
     SimpleImageStyle m_fboDrawStyle;
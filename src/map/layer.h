@@ -78,20 +78,18 @@ protected:
 };
 
 using LayerPtr = std::shared_ptr<Layer>;
-using FeatureIDs = std::set<GIntBig>;
+using FeatureIDs = FeatureIdSet;
 
 class ISelectableFeatureLayer {
 public:
     virtual ~ISelectableFeatureLayer() = default;
     virtual void setSelectedIds(const FeatureIDs &selectedIds) {
-        m_selectedFIDs.clear();
-        m_selectedFIDs.insert(selectedIds.begin(), selectedIds.end());
+        m_selectedFIDs = selectedIds;
     }
     virtual const FeatureIDs &selectedIds() const { return m_selectedFIDs; }
     virtual bool hasSelectedIds() const { return !m_selectedFIDs.empty(); }
     virtual void setHideIds(const FeatureIDs& hideIds = FeatureIDs()) {
-        m_hideFIDs.clear();
-        m_hideFIDs.insert(hideIds.begin(), hideIds.end());
+        m_hideFIDs = hideIds;
     }
 protected:
     FeatureIDs m_selectedFIDs;
@@ -31,6 +31,8 @@ namespace ngs {
 
 constexpr double DEFAULT_RATIO = 1.0;
 constexpr unsigned short MAX_TILES_COUNT = 32768; // 1.5 mb // 4096 * (4 + 4 + 1 + 8 * 4) = 164 kb
+constexpr int MIN_GEOMETRY_COVER_TILES = 4;
+constexpr size_t MAX_GEOMETRY_COVER_CELLS = 1 << 22; // 512 kb
 
 MapTransform::MapTransform(int width, int height) :
     m_displayWidht(width),
@@ -494,6 +496,219 @@ std::vector<TileItem> MapTransform::getTilesForExtent(
     return result;
 }
 
+using Segment = std::pair<OGRRawPoint, OGRRawPoint>;
+
+static bool collectSegments(const OGRGeometry *geometry,
+                            std::vector<Segment> &segments,
+                            std::vector<Segment> &ringSegments)
+{
+    if(nullptr == geometry || geometry->IsEmpty()) {
+        return true;
+    }
+
+    switch(OGR_GT_Flatten(geometry->getGeometryType())) {
+    case wkbPoint:
+    {
+        const OGRPoint *pt = static_cast<const OGRPoint*>(geometry);
+        OGRRawPoint rawPt(pt->getX(), pt->getY());
+        segments.push_back(std::make_pair(rawPt, rawPt));
+        return true;
+    }
+    case wkbLineString:
+    case wkbLinearRing:
+    {
+        const OGRLineString *line = static_cast<const OGRLineString*>(geometry);
+        for(int i = 1; i < line->getNumPoints(); ++i) {
+            segments.push_back(std::make_pair(
+                    OGRRawPoint(line->getX(i - 1), line->getY(i - 1)),
+                    OGRRawPoint(line->getX(i), line->getY(i))));
+        }
+        if(line->getNumPoints() == 1) {
+            OGRRawPoint rawPt(line->getX(0), line->getY(0));
+            segments.push_back(std::make_pair(rawPt, rawPt));
+        }
+        return true;
+    }
+    case wkbPolygon:
+    {
+        const OGRPolygon *polygon = static_cast<const OGRPolygon*>(geometry);
+        for(int i = -1; i < polygon->getNumInteriorRings(); ++i) {
+            const OGRLinearRing *ring = i < 0 ? polygon->getExteriorRing() :
+                                                polygon->getInteriorRing(i);
+            size_t start = segments.size();
+            collectSegments(ring, segments, ringSegments);
+            ringSegments.insert(ringSegments.end(), segments.begin() +
+                                static_cast<long>(start), segments.end());
+        }
+        return true;
+    }
+    case wkbMultiPoint:
+    case wkbMultiLineString:
+    case wkbMultiPolygon:
+    case wkbGeometryCollection:
+    {
+        const OGRGeometryCollection *collection =
+                static_cast<const OGRGeometryCollection*>(geometry);
+        for(int i = 0; i < collection->getNumGeometries(); ++i) {
+            if(!collectSegments(collection->getGeometryRef(i), segments,
+                                ringSegments)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief MapTransform::getTilesForGeometry Returns tiles intersecting the
+ * geometry itself instead of its envelope. Segments are walked column by
+ * column over the tile grid, polygon interiors are filled by scanline on tile
+ * row centres. Tiles are treated as extended by extraSize on each side.
+ * Falls back to getTilesForExtent for small covers and unsupported geometry.
+ * @param geometry Geometry to cover.
+ * @param zoom Zoom level.
+ * @param extraSize Tile extra size in map units.
+ * @param unlimitX Unlimited X scroll of the map.
+ * @return Tiles array.
+ */
+std::vector<TileItem> MapTransform::getTilesForGeometry(
+        const OGRGeometry &geometry, unsigned char zoom, double extraSize,
+        bool unlimitX)
+{
+    OGREnvelope ogrEnv;
+    geometry.getEnvelope(&ogrEnv);
+    Envelope extent(ogrEnv.MinX - extraSize, ogrEnv.MinY - extraSize,
+                    ogrEnv.MaxX + extraSize, ogrEnv.MaxY + extraSize);
+    if(zoom == 0) {
+        return getTilesForExtent(extent, zoom, false, unlimitX);
+    }
+
+    int tilesInMapOneDim = 1 << zoom;
+    double halfTilesInMapOneDim = tilesInMapOneDim * 0.5;
+    double tilesSizeOneDim = DEFAULT_BOUNDS.maxX() / halfTilesInMapOneDim;
+    int minX = unlimitX ? -tilesInMapOneDim : 0;
+    int maxX = unlimitX ? 2 * tilesInMapOneDim - 1 : tilesInMapOneDim - 1;
+    auto column = [&](double x) {
+        return std::min(std::max(static_cast<int>(std::floor(
+                x / tilesSizeOneDim + halfTilesInMapOneDim)), minX), maxX);
+    };
+    auto row = [&](double y) {
+        return std::min(std::max(static_cast<int>(std::floor(
+                y / tilesSizeOneDim + halfTilesInMapOneDim)), 0),
+                        tilesInMapOneDim - 1);
+    };
+
+    int begX = column(extent.minX());
+    int endX = column(extent.maxX()) + 1;
+    int begY = row(extent.minY());
+    int endY = row(extent.maxY()) + 1;
+    int cols = endX - begX;
+    int rows = endY - begY;
+    if(cols * rows <= MIN_GEOMETRY_COVER_TILES ||
+       static_cast<size_t>(cols) * static_cast<size_t>(rows) >
+            MAX_GEOMETRY_COVER_CELLS) {
+        return getTilesForExtent(extent, zoom, false, unlimitX);
+    }
+
+    std::vector<Segment> segments, ringSegments;
+    if(!collectSegments(&geometry, segments, ringSegments)) {
+        return getTilesForExtent(extent, zoom, false, unlimitX);
+    }
+
+    std::vector<bool> cells(static_cast<size_t>(cols * rows), false);
+    auto mark = [&](int x, int y) {
+        cells[static_cast<size_t>((x - begX) * rows + y - begY)] = true;
+    };
+
+    // Tiles touched by segments
+    for(const auto &segment : segments) {
+        const OGRRawPoint &a = segment.first;
+        const OGRRawPoint &b = segment.second;
+        int colBeg = column(std::min(a.x, b.x) - extraSize);
+        int colEnd = column(std::max(a.x, b.x) + extraSize);
+        for(int x = colBeg; x <= colEnd; ++x) {
+            double slabMin = (x - halfTilesInMapOneDim) * tilesSizeOneDim -
+                    extraSize;
+            double slabMax = slabMin + tilesSizeOneDim + 2 * extraSize;
+            double y0 = a.y, y1 = b.y;
+            if(!isEqual(a.x, b.x)) {
+                double t0 = (slabMin - a.x) / (b.x - a.x);
+                double t1 = (slabMax - a.x) / (b.x - a.x);
+                if(t0 > t1) {
+                    std::swap(t0, t1);
+                }
+                t0 = std::max(t0, 0.0);
+                t1 = std::min(t1, 1.0);
+                y0 = a.y + t0 * (b.y - a.y);
+                y1 = a.y + t1 * (b.y - a.y);
+            }
+            int rowBeg = row(std::min(y0, y1) - extraSize);
+            int rowEnd = row(std::max(y0, y1) + extraSize);
+            for(int y = rowBeg; y <= rowEnd; ++y) {
+                mark(x, y);
+            }
+        }
+    }
+
+    // Tiles inside polygons, even-odd rule on tile row centres
+    std::vector<double> crossings;
+    for(int y = begY; y < endY && !ringSegments.empty(); ++y) {
+        double centerY = (y - halfTilesInMapOneDim + 0.5) * tilesSizeOneDim;
+        crossings.clear();
+        for(const auto &segment : ringSegments) {
+            const OGRRawPoint &a = segment.first;
+            const OGRRawPoint &b = segment.second;
+            if((a.y > centerY) != (b.y > centerY)) {
+                crossings.push_back(a.x + (centerY - a.y) * (b.x - a.x) /
+                                    (b.y - a.y));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        for(size_t i = 1; i < crossings.size(); i += 2) {
+            int colBeg = static_cast<int>(std::ceil(crossings[i - 1] /
+                    tilesSizeOneDim + halfTilesInMapOneDim - 0.5));
+            int colEnd = static_cast<int>(std::floor(crossings[i] /
+                    tilesSizeOneDim + halfTilesInMapOneDim - 0.5));
+            for(int x = std::max(colBeg, begX); x <= std::min(colEnd, endX - 1);
+                ++x) {
+                mark(x, y);
+            }
+        }
+    }
+
+    std::vector<TileItem> result;
+    Envelope env;
+    for(int x = begX; x < endX; ++x) {
+        int realX = x;
+        char crossExt = 0;
+        if(realX < 0) {
+            crossExt = -1;
+            realX += tilesInMapOneDim;
+        }
+        else if(realX >= tilesInMapOneDim) {
+            crossExt = 1;
+            realX -= tilesInMapOneDim;
+        }
+        double tileMinX = DEFAULT_BOUNDS.minX() + realX * tilesSizeOneDim;
+        env.setMinX(tileMinX);
+        env.setMaxX(tileMinX + tilesSizeOneDim);
+        for(int y = begY; y < endY; ++y) {
+            if(!cells[static_cast<size_t>((x - begX) * rows + y - begY)]) {
+                continue;
+            }
+            double tileMinY = DEFAULT_BOUNDS.minY() + y * tilesSizeOneDim;
+            env.setMinY(tileMinY);
+            env.setMaxY(tileMinY + tilesSizeOneDim);
+            Tile tile = {realX, y, zoom, crossExt};
+            result.push_back({ tile, env });
+        }
+    }
+    return result;
+}
+
 OGRRawPoint MapTransform::worldToDisplay(const OGRRawPoint &pt) const
 {
     glm::vec4 newPt(static_cast<float>(pt.x), static_cast<float>(pt.y), 0.0f, 1.0f);
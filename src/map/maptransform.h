@@ -80,6 +80,10 @@ public:
                                                    unsigned char zoom,
                                                    bool reverseY,
                                                    bool unlimitX);
+    static std::vector<TileItem> getTilesForGeometry(const OGRGeometry &geometry,
+                                                     unsigned char zoom,
+                                                     double extraSize,
+                                                     bool unlimitX);
 
 protected:
     bool updateExtent();
@@ -359,7 +359,7 @@ bool EditLayerOverlay::editGeometry(const LayerPtr &layer, GIntBig featureId)
         return errorMessage(_("Geometry is null"));
     }
 
-    std::set<GIntBig> hideIds;
+    FeatureIDs hideIds;
     hideIds.insert(m_editFeatureId);
     featureLayer->setHideIds(hideIds);
 
@@ -145,6 +145,52 @@ Buffer &Buffer::put(GIntBig val)
     return *this;
 }
 
+Buffer &Buffer::put(double val)
+{
+    size_t size = sizeof(double);
+    reserve(size);
+
+    std::memcpy(m_data + m_currentPos, &val, size);
+    m_currentPos += size;
+    m_size += size;
+
+    return *this;
+}
+
+Buffer &Buffer::put(const GByte *data, size_t size)
+{
+    reserve(size);
+
+    std::memcpy(m_data + m_currentPos, data, size);
+    m_currentPos += size;
+    m_size += size;
+
+    return *this;
+}
+
+Buffer &Buffer::putVarint(GUIntBig val)
+{
+    // LEB128: 7 bits per byte, high bit set if more bytes follow.
+    GByte data[10];
+    size_t size = 0;
+    while(val >= 0x80) {
+        data[size++] = static_cast<GByte>(val | 0x80);
+        val >>= 7;
+    }
+    data[size++] = static_cast<GByte>(val);
+
+    return put(data, size);
+}
+
+void Buffer::reserve(size_t size)
+{
+    if(static_cast<size_t>(m_mallocSize) < m_currentPos + size) {
+        m_mallocSize = static_cast<int>(MAX(m_currentPos + size,
+                static_cast<size_t>(m_mallocSize) * 2));
+        m_data = static_cast<GByte*>(CPLRealloc(m_data, static_cast<size_t>(m_mallocSize)));
+    }
+}
+
 GUInt32 Buffer::getULong()
 {
     GUInt32 val = 0;
@@ -211,4 +257,30 @@ GIntBig Buffer::getBig()
     return val;
 }
 
+double Buffer::getDouble()
+{
+    double val = 0.0;
+    size_t size = sizeof(double);
+    if(m_currentPos + size > static_cast<size_t>(m_size))
+        return val;
+    std::memcpy(&val, m_data + m_currentPos, size);
+    m_currentPos += size;
+    return val;
+}
+
+GUIntBig Buffer::getVarint()
+{
+    GUIntBig val = 0;
+    int shift = 0;
+    while(m_currentPos < static_cast<size_t>(m_size) && shift < 64) {
+        GByte byte = m_data[m_currentPos++];
+        val |= static_cast<GUIntBig>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0) {
+            break;
+        }
+        shift += 7;
+    }
+    return val;
+}
+
 }
@@ -44,6 +44,9 @@ public:
     Buffer &put(GUInt16 val);
     Buffer &put(GUIntBig val);
     Buffer &put(GIntBig val);
+    Buffer &put(double val);
+    Buffer &put(const GByte *data, size_t size);
+    Buffer &putVarint(GUIntBig val);
 
     GUInt32 getULong();
     float getFloat();
@@ -51,8 +54,14 @@ public:
     GUInt16 getUShort();
     GUIntBig getUBig();
     GIntBig getBig();
+    double getDouble();
+    GUIntBig getVarint();
 
     void seek(size_t position) { m_currentPos = position; }
+    size_t position() const { return m_currentPos; }
+
+private:
+    void reserve(size_t size);
 
 private:
     int m_size;
@@ -20,6 +20,9 @@
  ****************************************************************************/
 #include "threadpool.h"
 
+// stl
+#include <iterator>
+
 #include "cpl_conv.h"
 
 namespace ngs {
@@ -30,7 +33,8 @@ namespace ngs {
 //------------------------------------------------------------------------------
 ThreadData::ThreadData(bool own) :
     m_own(own),
-    m_tries(0)
+    m_tries(0),
+    m_priority(0.0)
 {
 
 }
@@ -50,6 +54,21 @@ unsigned char ThreadData::tries() const
     return m_tries;
 }
 
+double ThreadData::priority() const
+{
+    return m_priority;
+}
+
+/**
+ * @brief ThreadData::setPriority Sets data processing priority. Data with
+ * lower value is processed first.
+ * @param priority Priority value. Default is 0.
+ */
+void ThreadData::setPriority(double priority)
+{
+    m_priority = priority;
+}
+
 //------------------------------------------------------------------------------
 // ThreadPool
 //------------------------------------------------------------------------------
@@ -80,12 +99,28 @@ void ThreadPool::init(unsigned char numThreads, poolThreadFunction function,
 void ThreadPool::addThreadData(ThreadData *data)
 {
     m_dataMutex.acquire(15.5);
-    m_threadData.push_back(data);
+    insertThreadData(data);
     m_dataMutex.release();
 
     newWorker();
 }
 
+/**
+ * @brief ThreadPool::insertThreadData Keeps queue ordered by priority, data of
+ * equal priority in order of adding. Data of default priority is appended at
+ * once. Caller must hold the data mutex.
+ * @param data Data to insert.
+ */
+void ThreadPool::insertThreadData(ThreadData *data)
+{
+    auto it = m_threadData.end();
+    while(it != m_threadData.begin() &&
+          (*std::prev(it))->priority() > data->priority()) {
+        --it;
+    }
+    m_threadData.insert(it, data);
+}
+
 void ThreadPool::clearThreadData()
 {
     MutexHolder holder(m_dataMutex, 25.5);
@@ -101,7 +136,7 @@ void ThreadPool::clearThreadData()
     m_threadData.clear();
 }
 
-void ThreadPool::waitComplete(const Progress &progress)
+void ThreadPool::waitComplete(const Progress &progress, double checkInterval)
 {
     bool complete = false;
     size_t currentDataCount = dataCount();
@@ -120,7 +155,7 @@ void ThreadPool::waitComplete(const Progress &progress)
             return;
         }
 
-        CPLSleep(0.55);
+        CPLSleep(checkInterval);
     }
 }
 
@@ -156,7 +191,7 @@ bool ThreadPool::process()
     else {
         data->increaseTries();
         MutexHolder holder(m_dataMutex, 19.5);
-        m_threadData.push_back(data);
+        insertThreadData(data);
     }
 
     return true;
@@ -41,10 +41,13 @@ public:
     bool isOwn() const;
     void increaseTries();
     unsigned char tries() const;
+    double priority() const;
+    void setPriority(double priority);
 
 protected:
     bool m_own;
     unsigned char m_tries;
+    double m_priority;
 };
 
 
@@ -64,12 +67,13 @@ public:
     void clearThreadData();
     unsigned char currentWorkerCount() const { return m_threadCount; }
     unsigned char maxWorkerCount() const { return m_maxThreadCount; }
-    void waitComplete(const Progress &progress);
+    void waitComplete(const Progress &progress, double checkInterval = 0.55);
     size_t dataCount() const { return m_threadData.size(); }
     bool isFailed() const { return m_failed; }
 
 protected:
     bool process();
+    void insertThreadData(ThreadData *data);
     void finished();
     void newWorker();
 
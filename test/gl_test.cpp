@@ -21,9 +21,14 @@
 
 #include "test.h"
 
+#include <chrono>
+#include <iostream>
+
 #include "cpl_conv.h"
 
 #include "ds/featureclass.h"
+#include "ds/featureclassovr.h"
+#include "map/gl/tile.h"
 #include "util/buffer.h"
 
 TEST(GlTests, TestTileBuffer) {
@@ -95,7 +100,7 @@ TEST(GlTests, TestTileBufferSaveLoad) {
     EXPECT_FLOAT_EQ(pt0.x, 12345.6f);
     EXPECT_FLOAT_EQ(pt0.y, 65432.1f);
 
-    std::set<GIntBig> idset1;
+    ngs::FeatureIdSet idset1;
     idset1.insert(777);
     idset1.insert(888);
     EXPECT_EQ(vitem3.isIdsPresent(idset1), true);
@@ -107,11 +112,552 @@ TEST(GlTests, TestTileBufferSaveLoad) {
     EXPECT_FLOAT_EQ(pt1.x, 23456.7f);
     EXPECT_FLOAT_EQ(pt1.y, 76543.2f);
 
-    std::set<GIntBig> idset2;
+    ngs::FeatureIdSet idset2;
     idset2.insert(555);
     EXPECT_EQ(vitem4.isIdsPresent(idset2), true);
 }
 
+TEST(GlTests, TestTileBufferCompact) {
+    ngs::VectorTile vtile0;
+    for(GIntBig i = 0; i < 100; ++i) {
+        ngs::VectorTileItem vitem;
+        vitem.addPoint({1000.0f + i, 2000.0f - i});
+        vitem.addPoint({1000.5f + i, 2000.5f - i});
+        vitem.addIndex(0);
+        vitem.addIndex(1);
+        vitem.addId(1000 + i);
+        vitem.setValid(true);
+        vtile0.add(vitem, false);
+    }
+
+    ngs::BufferPtr raw = vtile0.save();
+    ngs::BufferPtr compact = vtile0.save(0.25, true);
+    EXPECT_LT(compact->size(), raw->size());
+
+    ngs::VectorTile vtile1;
+    compact->seek(0);
+    EXPECT_TRUE(vtile1.load(*compact.get()));
+    ASSERT_EQ(vtile1.items().size(), 100);
+
+    ngs::VectorTileItem vitem1 = vtile1.items()[99];
+    ASSERT_EQ(vitem1.pointCount(), 2);
+    EXPECT_NEAR(vitem1.point(1).x, 1099.5f, 0.125f);
+    EXPECT_NEAR(vitem1.point(1).y, 1901.5f, 0.125f);
+    EXPECT_EQ(vitem1.indices()[1], 1);
+    ngs::FeatureIdSet idset;
+    idset.insert(1099);
+    EXPECT_TRUE(vitem1.isIdsPresent(idset));
+
+    // Version 1 blob without header.
+    ngs::Buffer buffer;
+    buffer.put(static_cast<GUInt32>(1));   // items
+    buffer.put(static_cast<GByte>(1));     // 2d
+    buffer.put(static_cast<GUInt32>(1));   // points
+    buffer.put(12345.6f);
+    buffer.put(65432.1f);
+    buffer.put(static_cast<GUInt32>(1));   // indices
+    buffer.put(static_cast<GUInt16>(0));
+    buffer.put(static_cast<GUInt32>(0));   // border indices
+    buffer.put(static_cast<GUInt32>(0));   // centroids
+    buffer.put(static_cast<GUInt32>(1));   // ids
+    buffer.put(static_cast<GIntBig>(777));
+
+    ngs::VectorTile vtile2;
+    buffer.seek(0);
+    EXPECT_TRUE(vtile2.load(buffer));
+    ASSERT_EQ(vtile2.items().size(), 1);
+    EXPECT_FLOAT_EQ(vtile2.items()[0].point(0).x, 12345.6f);
+    EXPECT_FLOAT_EQ(vtile2.items()[0].point(0).y, 65432.1f);
+}
+
+TEST(GlTests, TestTileIdRanges) {
+    // Cluster item has long ranges of consecutive ids
+    ngs::VectorTileItem vitem;
+    vitem.addPoint({100.0f, 200.0f});
+    for(GIntBig i = 0; i < 1000; ++i) {
+        vitem.addId(5000 + i);
+    }
+    vitem.addId(7);
+    vitem.addId(9000);
+    vitem.addId(9001);
+    vitem.setValid(true);
+
+    ngs::VectorTile vtile0;
+    vtile0.add(vitem, false);
+    ngs::BufferPtr buffer = vtile0.save(0.25);
+    EXPECT_LT(buffer->size(), 100);
+
+    ngs::VectorTile vtile1;
+    buffer->seek(0);
+    ASSERT_TRUE(vtile1.load(*buffer.get()));
+    ASSERT_EQ(vtile1.items().size(), 1);
+    const ngs::FeatureIdSet &ids = vtile1.items()[0].ids();
+    ASSERT_EQ(ids.size(), 1003);
+    EXPECT_TRUE(ids == vitem.ids());
+}
+
+TEST(GlTests, TestTileKey) {
+    ngs::Tile tiles[] = {{0, 0, 0, 0}, {16777215, 16777215, 24, 0},
+                         {3, 5, 4, -1}, {3, 5, 4, 1}, {3, 6, 4, -2},
+                         {4, 0, 4, 0}};
+    for(const ngs::Tile &tile : tiles) {
+        EXPECT_TRUE(ngs::ngsTileFromKey(ngs::ngsTileKey(tile)) == tile);
+    }
+
+    // Keys are sorted in the same order as tiles.
+    for(const ngs::Tile &tile0 : tiles) {
+        for(const ngs::Tile &tile1 : tiles) {
+            EXPECT_EQ(tile0 < tile1,
+                      ngs::ngsTileKey(tile0) < ngs::ngsTileKey(tile1));
+        }
+    }
+}
+
+TEST(GlTests, TestFeatureIdSet) {
+    ngs::FeatureIdSet ids;
+    EXPECT_TRUE(ids.empty());
+    ids.insert(5);
+    ids.insert(5);
+    EXPECT_EQ(ids.size(), 1);
+    ids.insert(3);
+    ids.insert(9);
+    ids.insert(7);
+    ASSERT_EQ(ids.size(), 4);
+    std::vector<GIntBig> sorted(ids.begin(), ids.end());
+    EXPECT_EQ(sorted, std::vector<GIntBig>({3, 5, 7, 9}));
+
+    std::vector<GIntBig> bigIds;
+    for(GIntBig i = 0; i < 1000; i += 2) {
+        bigIds.push_back(i);
+    }
+    ngs::FeatureIdSet big(bigIds.begin(), bigIds.end());
+    ngs::FeatureIdSet single;
+    single.insert(500);
+    EXPECT_TRUE(single.isSubsetOf(big));
+    EXPECT_TRUE(single.intersects(big));
+    EXPECT_FALSE(ids.intersects(big));
+    EXPECT_FALSE(ids.isSubsetOf(big));
+    ids.insert(10);
+    EXPECT_TRUE(big.intersects(ids));
+    EXPECT_EQ(ids.intersection(big).size(), 1);
+
+    // Unsorted range with duplicates
+    std::vector<GIntBig> unsortedIds = {8, 2, 6, 2, 4, 8};
+    ngs::FeatureIdSet ranged(unsortedIds.begin(), unsortedIds.end());
+    std::vector<GIntBig> rangedSorted(ranged.begin(), ranged.end());
+    EXPECT_EQ(rangedSorted, std::vector<GIntBig>({2, 4, 6, 8}));
+    ngs::FeatureIdSet one;
+    one.insert(4);
+    std::vector<GIntBig> sameIds = {4, 4};
+    one.insert(sameIds.begin(), sameIds.end());
+    ASSERT_EQ(one.size(), 1);
+    EXPECT_EQ(*one.begin(), 4);
+    EXPECT_EQ(one.memorySize(), 0);
+    one.insert(unsortedIds.begin(), unsortedIds.end());
+    EXPECT_TRUE(one == ranged);
+
+    EXPECT_TRUE(ids.erase(3));
+    EXPECT_FALSE(ids.erase(3));
+    EXPECT_TRUE(ids.erase(5));
+    EXPECT_TRUE(ids.erase(7));
+    EXPECT_TRUE(ids.erase(9));
+    ASSERT_EQ(ids.size(), 1);
+    EXPECT_EQ(*ids.begin(), 10);
+    EXPECT_TRUE(ids.contains(10));
+    EXPECT_EQ(ids.memorySize(), 0);
+}
+
+TEST(GlTests, TestTileCache) {
+    ngs::VectorTileItem vitem;
+    vitem.addPoint({12345.6f, 65432.1f});
+    vitem.addIndex(0);
+    vitem.addId(777);
+    vitem.setValid(true);
+    std::shared_ptr<ngs::VectorTile> vtile0(new ngs::VectorTile);
+    vtile0->add(vitem);
+
+    // Room for two tiles only.
+    ngs::VectorTileCache cache(vtile0->memorySize() * 2);
+    ngs::Tile tile0 = {0, 0, 1, 0}, tile1 = {1, 0, 1, 0}, tile2 = {0, 1, 1, 0};
+    GUIntBig generation = cache.generation();
+    EXPECT_TRUE(cache.put(tile0, vtile0, generation));
+    EXPECT_TRUE(cache.put(tile1, vtile0, generation));
+
+    // Cached tile is shared, not copied.
+    ngs::VectorTilePtr vtile1 = cache.get(tile0);
+    ASSERT_TRUE(vtile1);
+    EXPECT_EQ(vtile1.get(), vtile0.get());
+    EXPECT_EQ(vtile1->items().size(), 1);
+
+    // The least recently used tile1 is evicted.
+    EXPECT_TRUE(cache.put(tile2, vtile0, generation));
+    EXPECT_FALSE(cache.get(tile1));
+    EXPECT_TRUE(cache.get(tile2));
+
+    // Tile read before the remove is not cached.
+    cache.remove(tile0);
+    EXPECT_FALSE(cache.get(tile0));
+    EXPECT_FALSE(cache.put(tile0, vtile0, generation));
+    EXPECT_FALSE(cache.get(tile0));
+    EXPECT_TRUE(cache.put(tile0, vtile0, cache.generation()));
+    EXPECT_EQ(cache.hits(), 2);
+    EXPECT_EQ(cache.misses(), 3);
+}
+
+TEST(GlTests, TestGlTileCache) {
+    ngs::TileItem item0 = {{0, 0, 1, 0}, ngs::Envelope(0.0, 0.0, 10.0, 10.0)};
+    ngs::TileItem item1 = {{1, 0, 1, 0}, ngs::Envelope(10.0, 0.0, 20.0, 10.0)};
+    ngs::TileItem item2 = {{0, 1, 1, 0}, ngs::Envelope(0.0, 10.0, 10.0, 20.0)};
+    ngs::GlTilePtr tile0(new ngs::GlTile(256, item0));
+    ngs::GlTilePtr tile1(new ngs::GlTile(256, item1));
+    ngs::GlTilePtr tile2(new ngs::GlTile(256, item2));
+
+    // Room for two tiles only.
+    ngs::GlTileCache cache(2);
+    EXPECT_TRUE(cache.put(tile0, 1).empty());
+    EXPECT_TRUE(cache.put(tile1, 1).empty());
+    EXPECT_TRUE(cache.contains(tile0.get()));
+
+    // The least recently used tile0 is evicted.
+    auto evicted = cache.put(tile2, 2);
+    ASSERT_EQ(evicted.size(), 1);
+    EXPECT_EQ(evicted[0], tile0);
+    EXPECT_FALSE(cache.contains(tile0.get()));
+
+    // Placeholder lookup keeps the tile in cache.
+    EXPECT_EQ(cache.find(item1.tile, 1), tile1);
+    EXPECT_FALSE(cache.find(item1.tile, 2));
+    EXPECT_TRUE(cache.contains(tile1.get()));
+
+    // Taken tile leaves the cache with its generation.
+    GUIntBig generation = 0;
+    EXPECT_EQ(cache.take(item2.tile, generation), tile2);
+    EXPECT_EQ(generation, 2);
+    EXPECT_FALSE(cache.take(item2.tile, generation));
+
+    // Edit in tile1 extent drops it.
+    cache.put(tile2, 2);
+    auto removed = cache.remove(ngs::Envelope(15.0, 5.0, 16.0, 6.0));
+    ASSERT_EQ(removed.size(), 1);
+    EXPECT_EQ(removed[0], tile1);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.clear().size(), 1);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(GlTests, TestTilePresenceFilter) {
+    ngs::TilePresenceFilter filter(1000);
+    for(int i = 0; i < 1000; ++i) {
+        filter.add(i, i * 3);
+    }
+    for(int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filter.mayContain(i, i * 3));
+    }
+
+    int falsePositives = 0;
+    for(int i = 0; i < 10000; ++i) {
+        if(filter.mayContain(i, i * 3 + 1)) {
+            falsePositives++;
+        }
+    }
+    EXPECT_LT(falsePositives, 500);
+
+    ngs::BufferPtr buff = filter.save();
+    ngs::Buffer loadBuff(buff->data(), buff->size(), false);
+    ngs::TilePresenceFilter loaded;
+    ASSERT_TRUE(loaded.load(loadBuff));
+    for(int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(loaded.mayContain(i, i * 3));
+    }
+}
+
+TEST(GlTests, TestGEOSContextPerThread) {
+    const int count = 10000;
+    OGRPoint pt(12345.6, 65432.1);
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < count; ++i) {
+        ngs::GEOSContextHandlePtr handle;
+        ngs::GEOSGeometryWrap geom(pt.exportToGEOS(handle.get()), handle);
+        EXPECT_TRUE(geom.isValid());
+    }
+    auto newContextTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - t1).count();
+
+    t1 = std::chrono::high_resolution_clock::now();
+    for(int i = 0; i < count; ++i) {
+        ngs::GEOSGeometryWrap geom(&pt);
+        EXPECT_TRUE(geom.isValid());
+    }
+    auto threadContextTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - t1).count();
+
+    std::cout << "GEOS wrap per feature: new context "
+              << static_cast<double>(newContextTime) / count << " us, "
+              << "thread context "
+              << static_cast<double>(threadContextTime) / count << " us\n";
+
+    EXPECT_EQ(ngs::GEOSContextHandlePtr::threadHandle().get(),
+              ngs::GEOSContextHandlePtr::threadHandle().get());
+}
+
+TEST(GlTests, TestTileDuplicates) {
+    const int count = 20000;
+    ngs::VectorTileItemArray items;
+    for(int i = 0; i < count; ++i) {
+        ngs::VectorTileItem item;
+        item.addId(i);
+        item.addPoint({static_cast<float>(i % 200), static_cast<float>(i / 200)});
+        item.setValid(true);
+        items.push_back(item);
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    ngs::VectorTile tile;
+    tile.add(items, true);
+    // Same points from other features
+    for(auto &item : items) {
+        item.removeId(*item.ids().begin());
+        item.addId(count + 1);
+        item.setValid(true);
+    }
+    tile.add(items, true);
+    auto addTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - t1).count();
+    std::cout << "Add " << count * 2 << " items with duplicates check: "
+              << addTime << " us\n";
+
+    ASSERT_EQ(tile.items().size(), count);
+    EXPECT_EQ(tile.items()[10].ids().size(), 2);
+
+    // Index is rebuilt after remove
+    tile.remove(10);
+    tile.remove(count + 1);
+    EXPECT_EQ(tile.items().size(), count - 1);
+    ngs::VectorTileItem item;
+    item.addId(10);
+    item.addPoint({10.0f, 0.0f});
+    item.setValid(true);
+    tile.add(item, true);
+    tile.add(item, true);
+    EXPECT_EQ(tile.items().size(), count);
+}
+
+TEST(GlTests, TestTileItemsRestore) {
+    OGRLinearRing ring;
+    ring.addPoint(0, 0);
+    ring.addPoint(200, 0);
+    ring.addPoint(200, 100);
+    ring.addPoint(0, 100);
+    ring.addPoint(0, 0);
+    OGRPolygon polygon;
+    polygon.addRing(&ring);
+
+    // Clip polygon by two tiles with extra extent as overviews do
+    ngs::GEOSGeometryPtr geom(new ngs::GEOSGeometryWrap(&polygon));
+    ngs::VectorTileItemArray items;
+    ngs::Envelope left(-10, -10, 110, 110);
+    ngs::Envelope right(90, -10, 210, 110);
+    geom->clip(left)->fillTile(1, items);
+    geom->clip(right)->fillTile(1, items);
+    ASSERT_EQ(items.size(), 2);
+
+    std::vector<ngs::VectorTileItemRef> pieces = {
+        std::make_pair(&items[0], OGRRawPoint()),
+        std::make_pair(&items[1], OGRRawPoint()) };
+    ngs::GEOSGeometryPtr restored =
+            ngs::GEOSGeometryWrap::createFromTileItems(pieces, wkbPolygon);
+    ASSERT_TRUE(restored && restored->isValid());
+
+    ngs::VectorTileItemArray outItems;
+    restored->fillTile(1, outItems);
+    ASSERT_EQ(outItems.size(), 1);
+    EXPECT_EQ(outItems[0].borderIndices().size(), 1);
+    EXPECT_TRUE(restored->intersects(100, 50));
+    EXPECT_FALSE(restored->intersects(150, 150));
+}
+
+TEST(GlTests, TestTileLocalCoordinates) {
+    // Point at building scale detail, float step here is 0.25 m
+    const double x = 4187654.321, y = 7512345.678;
+    const unsigned char z = 20;
+    double tileSize = ngs::DEFAULT_BOUNDS.width() / (1 << z);
+    ngs::Tile tile = {
+        static_cast<int>((x - ngs::DEFAULT_BOUNDS.minX()) / tileSize),
+        static_cast<int>((y - ngs::DEFAULT_BOUNDS.minY()) / tileSize), z, 0};
+    OGRRawPoint origin = ngs::ngsTileOrigin(tile);
+    ngs::Envelope env(origin.x, origin.y, origin.x + tileSize,
+                      origin.y + tileSize);
+    env.resize(1.1);
+
+    OGRPoint point(x, y);
+    ngs::GEOSGeometryPtr geom(new ngs::GEOSGeometryWrap(&point));
+    ngs::VectorTileItemArray items;
+    geom->fillClippedTile(1, env, items, origin);
+    ASSERT_EQ(items.size(), 1);
+    EXPECT_NEAR(items[0].point(0).x, x - origin.x, 0.001);
+    EXPECT_NEAR(items[0].point(0).y, y - origin.y, 0.001);
+
+    std::vector<ngs::VectorTileItemRef> pieces = {
+        std::make_pair(&items[0], origin) };
+    ngs::GEOSGeometryPtr restored =
+            ngs::GEOSGeometryWrap::createFromTileItems(pieces, wkbPoint);
+    ASSERT_TRUE(restored && restored->isValid());
+    EXPECT_LT(restored->distance(x, y), 0.001);
+
+    // Blob with absolute coordinates is moved to the tile origin on load
+    ngs::Buffer buffer;
+    buffer.put(static_cast<GUInt32>(1));   // items
+    buffer.put(static_cast<GByte>(1));     // 2d
+    buffer.put(static_cast<GUInt32>(1));   // points
+    buffer.put(static_cast<float>(x));
+    buffer.put(static_cast<float>(y));
+    buffer.put(static_cast<GUInt32>(0));   // indices
+    buffer.put(static_cast<GUInt32>(0));   // border indices
+    buffer.put(static_cast<GUInt32>(0));   // centroids
+    buffer.put(static_cast<GUInt32>(1));   // ids
+    buffer.put(static_cast<GIntBig>(1));
+    buffer.seek(0);
+    ngs::VectorTile vtile;
+    EXPECT_TRUE(vtile.load(buffer, origin));
+    ASSERT_EQ(vtile.items().size(), 1);
+    EXPECT_NEAR(vtile.items()[0].point(0).x, x - origin.x, 0.5);
+    EXPECT_NEAR(vtile.items()[0].point(0).y, y - origin.y, 0.5);
+
+    // Saved tile keeps local coordinates
+    ngs::VectorTile localTile;
+    localTile.add(items);
+    ngs::BufferPtr saved = localTile.save(0.01, true);
+    saved->seek(0);
+    ngs::VectorTile loaded;
+    EXPECT_TRUE(loaded.load(*saved.get(), origin));
+    ASSERT_EQ(loaded.items().size(), 1);
+    EXPECT_NEAR(loaded.items()[0].point(0).x, x - origin.x, 0.01);
+    EXPECT_NEAR(loaded.items()[0].point(0).y, y - origin.y, 0.01);
+}
+
+TEST(GlTests, TestSimplifyLine) {
+    // Zigzag far below tolerance collapses to end points
+    OGRLineString line;
+    for(int i = 0; i <= 1000; ++i) {
+        line.addPoint(i, (i % 2) * 0.1);
+    }
+
+    ngs::GEOSGeometryWrap::SimplifyType types[] = {
+        ngs::GEOSGeometryWrap::SimplifyType::DOUGLAS_PEUCKER,
+        ngs::GEOSGeometryWrap::SimplifyType::VISVALINGAM };
+    for(auto type : types) {
+        ngs::GEOSGeometryPtr geom(new ngs::GEOSGeometryWrap(&line));
+        geom->simplify(1.0, type);
+        ngs::VectorTileItemArray items;
+        geom->fillTile(1, items);
+        ASSERT_EQ(items.size(), 1);
+        ASSERT_EQ(items[0].pointCount(), 2);
+        EXPECT_DOUBLE_EQ(items[0].points()[0].x, 0.0);
+        EXPECT_DOUBLE_EQ(items[0].points()[1].x, 1000.0);
+    }
+}
+
+TEST(GlTests, TestSimplifyPolygon) {
+    OGRLinearRing ring;
+    for(int i = 0; i < 720; ++i) {
+        double angle = i * M_PI / 360;
+        ring.addPoint(100 * cos(angle), 100 * sin(angle));
+    }
+    ring.closeRings();
+    OGRPolygon polygon;
+    polygon.addRing(&ring);
+
+    ngs::GEOSGeometryWrap::SimplifyType types[] = {
+        ngs::GEOSGeometryWrap::SimplifyType::DOUGLAS_PEUCKER,
+        ngs::GEOSGeometryWrap::SimplifyType::VISVALINGAM };
+    for(auto type : types) {
+        ngs::GEOSGeometryPtr geom(new ngs::GEOSGeometryWrap(&polygon));
+        geom->simplify(1.0, type);
+        ngs::VectorTileItemArray items;
+        geom->fillTile(1, items);
+        ASSERT_EQ(items.size(), 1);
+        EXPECT_GE(items[0].pointCount(), 4);
+        EXPECT_LT(items[0].pointCount(), 720);
+        EXPECT_TRUE(geom->intersects(0, 0));
+        EXPECT_TRUE(geom->intersects(98, 0));
+    }
+
+    EXPECT_EQ(ngs::GEOSGeometryWrap::simplifyTypeFromString("VW"),
+              ngs::GEOSGeometryWrap::SimplifyType::VISVALINGAM);
+    EXPECT_EQ(ngs::GEOSGeometryWrap::simplifyTypeFromString(""),
+              ngs::GEOSGeometryWrap::SimplifyType::GRID);
+}
+
+TEST(GlTests, TestClipToTile) {
+    ngs::Envelope env(0, 0, 100, 100);
+
+    // Line goes out and back in, two parts expected
+    OGRLineString line;
+    line.addPoint(-50, 50);
+    line.addPoint(50, 50);
+    line.addPoint(50, 150);
+    line.addPoint(80, 150);
+    line.addPoint(80, 50);
+    ngs::GEOSGeometryWrap lineGeom(&line);
+    ngs::VectorTileItemArray lineItems;
+    lineGeom.fillClippedTile(1, env, lineItems);
+    ASSERT_EQ(lineItems.size(), 2);
+    EXPECT_EQ(lineItems[0].pointCount(), 3);
+    EXPECT_FLOAT_EQ(lineItems[0].point(0).x, 0.0f);
+    EXPECT_FLOAT_EQ(lineItems[0].point(2).y, 100.0f);
+    EXPECT_EQ(lineItems[1].pointCount(), 2);
+
+    // Square with hole larger than tile, the hole is clipped too
+    OGRLinearRing *exterior = new OGRLinearRing;
+    exterior->addPoint(-100, -100);
+    exterior->addPoint(200, -100);
+    exterior->addPoint(200, 200);
+    exterior->addPoint(-100, 200);
+    exterior->closeRings();
+    OGRLinearRing *hole = new OGRLinearRing;
+    hole->addPoint(40, 40);
+    hole->addPoint(40, 150);
+    hole->addPoint(60, 150);
+    hole->addPoint(60, 40);
+    hole->closeRings();
+    OGRPolygon polygon;
+    polygon.addRingDirectly(exterior);
+    polygon.addRingDirectly(hole);
+
+    ngs::GEOSGeometryWrap polygonGeom(&polygon);
+    ngs::VectorTileItemArray polygonItems;
+    polygonGeom.fillClippedTile(1, env, polygonItems);
+    ASSERT_EQ(polygonItems.size(), 1);
+    EXPECT_EQ(polygonItems[0].borderIndices().size(), 2);
+    for(const auto &pt : polygonItems[0].points()) {
+        EXPECT_GE(pt.x, 0.0f);
+        EXPECT_LE(pt.x, 100.0f);
+        EXPECT_GE(pt.y, 0.0f);
+        EXPECT_LE(pt.y, 100.0f);
+    }
+
+    // Same items count as GEOS clip
+    ngs::VectorTileItemArray geosItems;
+    polygonGeom.clip(env)->fillTile(1, geosItems);
+    EXPECT_EQ(geosItems.size(), polygonItems.size());
+
+    // Tile inside the hole, nothing left as in GEOS clip
+    ngs::Envelope holeEnv(45, 50, 55, 60);
+    ngs::VectorTileItemArray holeItems;
+    polygonGeom.fillClippedTile(1, holeEnv, holeItems);
+    EXPECT_TRUE(holeItems.empty());
+    ngs::VectorTileItemArray geosHoleItems;
+    polygonGeom.clip(holeEnv)->fillTile(1, geosHoleItems);
+    EXPECT_EQ(geosHoleItems.size(), holeItems.size());
+
+    // Outside tile
+    ngs::VectorTileItemArray emptyItems;
+    polygonGeom.fillClippedTile(1, ngs::Envelope(300, 300, 400, 400),
+                                emptyItems);
+    EXPECT_TRUE(emptyItems.empty());
+}
+
 /*
 TEST(GlTests, TestCreate) {
 #ifdef OFFSCREEN_GL
@@ -21,14 +21,21 @@
 
 #include "test.h"
 
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <set>
 
 // gdal
 #include "cpl_string.h"
 
 #include "api_priv.h"
+#include "ds/dataset.h"
+#include "ds/featureclassovr.h"
 #include "ds/geometry.h"
+#include "ds/tilestore.h"
+#include "map/maptransform.h"
 #include "ngstore/api.h"
 #include "ngstore/version.h"
 
@@ -861,6 +868,578 @@ TEST(DataStoreTest, TestCreateMemoryDatasource) {
     ngsUnInit();
 }
 
+TEST(DataStoreTests, TestOverviewsThreadScaling) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_scaling");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_scaling"));
+    ASSERT_NE(fc, nullptr);
+
+    for(int threads : {1, 2, 4, 8}) {
+        options = nullptr;
+        options = ngsListAddNameValue(options, "FORCE", "ON");
+        options = ngsListAddNameValue(options, "ZOOM_LEVELS", "10,12,14,16");
+        options = ngsListAddNameIntValue(options, "NUM_THREADS", threads);
+        auto start = std::chrono::high_resolution_clock::now();
+        int result = ngsFeatureClassCreateOverviews(fc, options,
+                                                    ngsTestProgressFunc, nullptr);
+        auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::high_resolution_clock::now() - start).count();
+        ngsListFree(options);
+        if(result == COD_INVALID) {
+            std::cout << "Feature class has no overviews support, skip test\n";
+            break;
+        }
+        EXPECT_EQ(result, COD_SUCCESS);
+        std::cout << "Create overviews with " << threads << " threads: "
+                  << time << " ms\n";
+    }
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+TEST(DataStoreTests, TestOverviewsCheckpoint) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_checkpoint");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_checkpoint"));
+    ASSERT_NE(fc, nullptr);
+
+    // Build with small checkpoints, then resume finished build
+    for(const char *resume : {"NO", "YES"}) {
+        options = nullptr;
+        options = ngsListAddNameValue(options, "FORCE", "ON");
+        options = ngsListAddNameValue(options, "ZOOM_LEVELS", "12,14");
+        options = ngsListAddNameValue(options, "CHECKPOINT_FEATURES", "100");
+        options = ngsListAddNameValue(options, "RESUME", resume);
+        int result = ngsFeatureClassCreateOverviews(fc, options,
+                                                    ngsTestProgressFunc, nullptr);
+        ngsListFree(options);
+        if(result == COD_INVALID) {
+            std::cout << "Feature class has no overviews support, skip test\n";
+            break;
+        }
+        EXPECT_EQ(result, COD_SUCCESS);
+    }
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+// Tile items as first feature id and point count, independent of items order
+using OverviewSummary = std::map<ngs::Tile,
+    std::multiset<std::pair<GIntBig, size_t>>>;
+
+static OverviewSummary overviewSummary(ngs::FeatureClassOverview *featureClass)
+{
+    OverviewSummary out;
+    for(unsigned char zoom : featureClass->zoomLevels()) {
+        auto tiles = ngs::MapTransform::getTilesForExtent(
+                    featureClass->extent(), zoom, false, false);
+        for(const auto &tileItem : tiles) {
+            ngs::VectorTilePtr vtile = featureClass->getTile(tileItem.tile,
+                                                             tileItem.env);
+            for(const auto &item : vtile->items()) {
+                GIntBig fid = item.ids().empty() ? -1 : *item.ids().begin();
+                out[tileItem.tile].insert(std::make_pair(fid,
+                                                         item.pointCount()));
+            }
+        }
+    }
+    return out;
+}
+
+TEST(DataStoreTests, TestOverviewsMemoryBudget) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_budget");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_budget"));
+    ASSERT_NE(fc, nullptr);
+    ngs::FeatureClassOverview *featureClass =
+            dynamic_cast<ngs::FeatureClassOverview*>(static_cast<ngs::Object*>(fc));
+    if(nullptr == featureClass) {
+        std::cout << "Feature class has no overviews support, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    // In memory build, then build with tiles spilled to many runs on disk
+    OverviewSummary summaries[2];
+    const char *budgets[] = {"128", "0.01"};
+    for(int i = 0; i < 2; ++i) {
+        options = nullptr;
+        options = ngsListAddNameValue(options, "FORCE", "ON");
+        options = ngsListAddNameValue(options, "ZOOM_LEVELS", "10,12,14");
+        options = ngsListAddNameValue(options, "MEMORY_BUDGET", budgets[i]);
+        EXPECT_EQ(ngsFeatureClassCreateOverviews(fc, options,
+                                                 ngsTestProgressFunc, nullptr),
+                  COD_SUCCESS);
+        ngsListFree(options);
+        summaries[i] = overviewSummary(featureClass);
+    }
+
+    EXPECT_FALSE(summaries[0].empty());
+    EXPECT_TRUE(summaries[0] == summaries[1]);
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+TEST(DataStoreTests, TestOverviewsNearestTile) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_nearest");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_nearest"));
+    ASSERT_NE(fc, nullptr);
+    ngs::FeatureClassOverview *featureClass =
+            dynamic_cast<ngs::FeatureClassOverview*>(static_cast<ngs::Object*>(fc));
+    if(nullptr == featureClass) {
+        std::cout << "Feature class has no overviews support, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    options = nullptr;
+    options = ngsListAddNameValue(options, "FORCE", "ON");
+    options = ngsListAddNameValue(options, "ZOOM_LEVELS", "12,15");
+    EXPECT_EQ(ngsFeatureClassCreateOverviews(fc, options,
+                                             ngsTestProgressFunc, nullptr),
+              COD_SUCCESS);
+    ngsListFree(options);
+
+    // Zoom 11 and 14 are built from finer levels, zoom 13 from coarser one
+    for(unsigned char zoom : {11, 13, 14}) {
+        auto tiles = ngs::MapTransform::getTilesForExtent(
+                    featureClass->extent(), zoom, false, false);
+        size_t itemCount = 0;
+        for(const auto &tileItem : tiles) {
+            itemCount += featureClass->getTile(tileItem.tile,
+                                               tileItem.env)->items().size();
+        }
+        EXPECT_GT(itemCount, 0);
+
+        // Built tiles are cached
+        GUIntBig hits = featureClass->tileCacheHits();
+        GUIntBig misses = featureClass->tileCacheMisses();
+        for(const auto &tileItem : tiles) {
+            featureClass->getTile(tileItem.tile, tileItem.env);
+        }
+        EXPECT_GT(featureClass->tileCacheHits(), hits);
+        EXPECT_EQ(featureClass->tileCacheMisses(), misses);
+    }
+
+    // Zoom 9 is too far from stored levels and is tiled on the fly
+    auto tiles = ngs::MapTransform::getTilesForExtent(featureClass->extent(), 9,
+                                                      false, false);
+    size_t itemCount = 0;
+    for(const auto &tileItem : tiles) {
+        itemCount += featureClass->getTile(tileItem.tile,
+                                           tileItem.env)->items().size();
+    }
+    EXPECT_GT(itemCount, 0);
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+// Cancels after the given number of progress calls
+static int cancelProgressFunc(enum ngsCode /*status*/, double /*complete*/,
+                              const char* /*message*/, void* progressArguments)
+{
+    int *calls = static_cast<int*>(progressArguments);
+    return --(*calls) > 0 ? TRUE : FALSE;
+}
+
+TEST(DataStoreTests, TestOverviewsCheckpointResume) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_resume");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_resume"));
+    ASSERT_NE(fc, nullptr);
+    ngs::FeatureClassOverview *featureClass =
+            dynamic_cast<ngs::FeatureClassOverview*>(static_cast<ngs::Object*>(fc));
+    if(nullptr == featureClass) {
+        std::cout << "Feature class has no overviews support, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    // Build without checkpoints, then interrupt build with checkpoints and
+    // resume it from saved runs
+    OverviewSummary summaries[2];
+    for(int i = 0; i < 2; ++i) {
+        options = nullptr;
+        options = ngsListAddNameValue(options, "FORCE", "ON");
+        options = ngsListAddNameValue(options, "ZOOM_LEVELS", "12,14");
+        options = ngsListAddNameValue(options, "MEMORY_BUDGET", "0.01");
+        if(i > 0) {
+            options = ngsListAddNameValue(options, "CHECKPOINT_FEATURES", "100");
+            int calls = 10;
+            ngsFeatureClassCreateOverviews(fc, options, cancelProgressFunc,
+                                           &calls);
+        }
+        EXPECT_EQ(ngsFeatureClassCreateOverviews(fc, options,
+                                                 ngsTestProgressFunc, nullptr),
+                  COD_SUCCESS);
+        ngsListFree(options);
+        summaries[i] = overviewSummary(featureClass);
+    }
+
+    EXPECT_FALSE(summaries[0].empty());
+    EXPECT_TRUE(summaries[0] == summaries[1]);
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+static bool overviewSummaryHasFid(const OverviewSummary &summary, GIntBig fid)
+{
+    for(const auto &tile : summary) {
+        for(const auto &item : tile.second) {
+            if(item.first == fid) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+TEST(DataStoreTests, TestOverviewsEditFlush) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CPLString shapePath = catalogPath + "/data/bld.shp";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    CatalogObjectH shape = ngsCatalogObjectGet(shapePath);
+
+    char **options = nullptr;
+    options = ngsListAddNameValue(options, "NEW_NAME", "ovr_flush");
+    EXPECT_EQ(ngsCatalogObjectCopy(shape, store, options,
+                                   ngsTestProgressFunc, nullptr), COD_SUCCESS);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_flush"));
+    ASSERT_NE(fc, nullptr);
+    ngs::FeatureClassOverview *featureClass =
+            dynamic_cast<ngs::FeatureClassOverview*>(static_cast<ngs::Object*>(fc));
+    if(nullptr == featureClass) {
+        std::cout << "Feature class has no overviews support, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    options = nullptr;
+    options = ngsListAddNameValue(options, "FORCE", "ON");
+    options = ngsListAddNameValue(options, "ZOOM_LEVELS", "12,14");
+    EXPECT_EQ(ngsFeatureClassCreateOverviews(fc, options,
+                                             ngsTestProgressFunc, nullptr),
+              COD_SUCCESS);
+    ngsListFree(options);
+
+    // Move the first feature geometry to the new feature
+    featureClass->reset();
+    ngs::FeaturePtr feature = featureClass->nextFeature();
+    ASSERT_TRUE(feature);
+    GIntBig oldFid = feature->GetFID();
+    ngs::FeaturePtr newFeature = featureClass->createFeature();
+    newFeature->SetGeometry(feature->GetGeometryRef());
+    feature.reset();
+    EXPECT_TRUE(featureClass->deleteFeature(oldFid, false));
+    EXPECT_TRUE(featureClass->insertFeature(newFeature, false));
+    GIntBig newFid = newFeature->GetFID();
+
+    // Edits are read from pending tiles
+    EXPECT_GT(featureClass->dirtyTilesCount(), 0);
+    OverviewSummary pending = overviewSummary(featureClass);
+    EXPECT_FALSE(overviewSummaryHasFid(pending, oldFid));
+    EXPECT_TRUE(overviewSummaryHasFid(pending, newFid));
+
+    // And from the overviews table after the flush
+    EXPECT_TRUE(featureClass->flushDirtyTiles());
+    EXPECT_EQ(featureClass->dirtyTilesCount(), 0);
+    OverviewSummary flushed = overviewSummary(featureClass);
+    EXPECT_TRUE(pending == flushed);
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+// Largest cluster size and largest items count of tile
+static std::pair<size_t, size_t> clusterSummary(
+        ngs::FeatureClassOverview *featureClass, unsigned char zoom,
+        const ngs::Envelope &env)
+{
+    std::pair<size_t, size_t> out(0, 0);
+    for(const auto &tileItem : ngs::MapTransform::getTilesForExtent(
+            env, zoom, false, false)) {
+        ngs::VectorTilePtr vtile = featureClass->getTile(tileItem.tile,
+                                                         tileItem.env);
+        out.second = std::max(out.second, vtile->items().size());
+        for(const auto &item : vtile->items()) {
+            out.first = std::max(out.first, item.ids().size());
+        }
+    }
+    return out;
+}
+
+TEST(DataStoreTests, TestOverviewsClusterEdit) {
+    initLib();
+
+    CPLString testPath = ngsGetCurrentDirectory();
+    CPLString catalogPath = ngsCatalogPathFromSystem(testPath);
+    CPLString storePath = catalogPath + "/tmp/main.ngst";
+    CatalogObjectH store = ngsCatalogObjectGet(storePath);
+    ASSERT_NE(store, nullptr);
+
+    char **options = nullptr;
+    options = ngsListAddNameIntValue(options, "TYPE", CAT_FC_GPKG);
+    options = ngsListAddNameValue(options, "GEOMETRY_TYPE", "POINT");
+    options = ngsListAddNameValue(options, "FIELD_COUNT", "1");
+    options = ngsListAddNameValue(options, "FIELD_0_TYPE", "INTEGER");
+    options = ngsListAddNameValue(options, "FIELD_0_NAME", "type");
+    EXPECT_NE(ngsCatalogObjectCreate(store, "ovr_clusters", options), nullptr);
+    ngsListFree(options);
+
+    CatalogObjectH fc = ngsCatalogObjectGet(CPLString(storePath + "/ovr_clusters"));
+    ASSERT_NE(fc, nullptr);
+    ngs::FeatureClassOverview *featureClass =
+            dynamic_cast<ngs::FeatureClassOverview*>(static_cast<ngs::Object*>(fc));
+    if(nullptr == featureClass) {
+        std::cout << "Feature class has no overviews support, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    // Points of one cluster cell on both zoom levels
+    auto addPoint = [featureClass](double x, double y) {
+        ngs::FeaturePtr feature = featureClass->createFeature();
+        feature->SetGeometryDirectly(new OGRPoint(x, y));
+        EXPECT_TRUE(featureClass->insertFeature(feature, false));
+        return feature->GetFID();
+    };
+    GIntBig firstFid = addPoint(1000000.0, 1000000.0);
+    addPoint(1000100.0, 1000000.0);
+    addPoint(1000000.0, 1000100.0);
+
+    options = nullptr;
+    options = ngsListAddNameValue(options, "FORCE", "ON");
+    options = ngsListAddNameValue(options, "ZOOM_LEVELS", "5,10");
+    options = ngsListAddNameValue(options, "CLUSTER_POINTS", "ON");
+    EXPECT_EQ(ngsFeatureClassCreateOverviews(fc, options,
+                                             ngsTestProgressFunc, nullptr),
+              COD_SUCCESS);
+    ngsListFree(options);
+    ASSERT_TRUE(featureClass->hasPointClusters());
+
+    ngs::Envelope env(999000.0, 999000.0, 1002000.0, 1002000.0);
+    for(unsigned char zoom : {5, 10}) {
+        auto summary = clusterSummary(featureClass, zoom, env);
+        EXPECT_EQ(summary.first, 3);
+        EXPECT_EQ(summary.second, 1);
+    }
+
+    // Edits update the cluster instead of adding single points
+    GIntBig fid = addPoint(1000050.0, 1000050.0);
+    for(unsigned char zoom : {5, 10}) {
+        auto summary = clusterSummary(featureClass, zoom, env);
+        EXPECT_EQ(summary.first, 4);
+        EXPECT_EQ(summary.second, 1);
+    }
+
+    EXPECT_TRUE(featureClass->deleteFeature(fid, false));
+    EXPECT_TRUE(featureClass->flushDirtyTiles());
+    for(unsigned char zoom : {5, 10}) {
+        auto summary = clusterSummary(featureClass, zoom, env);
+        EXPECT_EQ(summary.first, 3);
+        EXPECT_EQ(summary.second, 1);
+    }
+
+    // Moved member updates its cluster found by member ids
+    ngs::FeaturePtr feature = featureClass->getFeature(firstFid);
+    ASSERT_TRUE(feature);
+    feature->SetGeometryDirectly(new OGRPoint(1000020.0, 1000020.0));
+    EXPECT_TRUE(featureClass->updateFeature(feature, false));
+    for(unsigned char zoom : {5, 10}) {
+        auto summary = clusterSummary(featureClass, zoom, env);
+        EXPECT_EQ(summary.first, 3);
+        EXPECT_EQ(summary.second, 1);
+    }
+
+    EXPECT_EQ(ngsCatalogObjectDelete(fc), COD_SUCCESS);
+    ngsUnInit();
+}
+
+TEST(DataStoreTests, TestOverviewTileStoreLatency) {
+    initLib();
+
+    std::string path = ngsFormFileName(ngsGetCurrentDirectory(), "tmp",
+                                       nullptr, 0);
+    path = ngsFormFileName(path.c_str(), "tile_store", "gpkg", 0);
+    GDALDriver *driver = GetGDALDriverManager()->GetDriverByName("GPKG");
+    ASSERT_NE(driver, nullptr);
+    ngs::GDALDatasetPtr ds = driver->Create(path.c_str(), 0, 0, 0, GDT_Unknown,
+                                            nullptr);
+    ASSERT_NE(ds, nullptr);
+
+    OGRLayer *layer = ds->CreateLayer("overviews", nullptr, wkbNone, nullptr);
+    ASSERT_NE(layer, nullptr);
+    OGRFieldDefn xField(ngs::OVR_X_KEY, OFTInteger);
+    OGRFieldDefn yField(ngs::OVR_Y_KEY, OFTInteger);
+    OGRFieldDefn zField(ngs::OVR_ZOOM_KEY, OFTInteger);
+    OGRFieldDefn tileField(ngs::OVR_TILE_KEY, OFTBinary);
+    layer->CreateField(&xField);
+    layer->CreateField(&yField);
+    layer->CreateField(&zField);
+    layer->CreateField(&tileField);
+
+    ngs::OverviewTileStore store(ds.get(), "overviews");
+    if(!store.isOpened()) {
+        std::cout << "SQLite handle is not available, skip test\n";
+        ngsUnInit();
+        return;
+    }
+
+    const int tilesInDim = 32;
+    std::vector<GByte> data(4096);
+    for(size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<GByte>(i % 251);
+    }
+
+    ds->StartTransaction();
+    for(int x = 0; x < tilesInDim; ++x) {
+        for(int y = 0; y < tilesInDim; ++y) {
+            ngs::Tile tile = {x, y, 10, 0};
+            ASSERT_TRUE(store.insertTile(tile, data.data(), data.size()));
+        }
+    }
+    ds->CommitTransaction();
+    ds->ExecuteSQL("CREATE INDEX overviews_idx on overviews (x, y, z)",
+                   nullptr, nullptr);
+
+    // Current path: attribute filter and OGR feature per tile
+    auto start = std::chrono::high_resolution_clock::now();
+    for(int x = 0; x < tilesInDim; ++x) {
+        for(int y = 0; y < tilesInDim; ++y) {
+            layer->SetAttributeFilter(CPLSPrintf("%s = %d AND %s = %d AND %s = %d",
+                                                 ngs::OVR_X_KEY, x,
+                                                 ngs::OVR_Y_KEY, y,
+                                                 ngs::OVR_ZOOM_KEY, 10));
+            ngs::FeaturePtr feature(layer->GetNextFeature());
+            ASSERT_TRUE(feature);
+            int size = 0;
+            feature->GetFieldAsBinary(feature->GetFieldIndex(ngs::OVR_TILE_KEY),
+                                      &size);
+            EXPECT_EQ(size, static_cast<int>(data.size()));
+        }
+    }
+    layer->SetAttributeFilter(nullptr);
+    auto ogrTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+
+    // Tile store path
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<GByte> readData;
+    for(int x = 0; x < tilesInDim; ++x) {
+        for(int y = 0; y < tilesInDim; ++y) {
+            ngs::Tile tile = {x, y, 10, 0};
+            ASSERT_TRUE(store.readTile(tile, readData));
+            EXPECT_EQ(readData, data);
+        }
+    }
+    auto storeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+
+    // Whole viewport in one query
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<ngs::OverviewTileStore::TileData> tiles;
+    EXPECT_TRUE(store.readTiles(10, 0, 0, tilesInDim - 1, tilesInDim - 1,
+                                tiles));
+    auto batchTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+    EXPECT_EQ(tiles.size(), static_cast<size_t>(tilesInDim * tilesInDim));
+
+    const double count = tilesInDim * tilesInDim;
+    std::cout << "Tile read latency, us: OGR - " << ogrTime / count <<
+                 ", tile store - " << storeTime / count <<
+                 ", batch - " << batchTime / count << "\n";
+
+    // Update and delete
+    ngs::Tile tile = {0, 0, 10, 0};
+    EXPECT_TRUE(store.writeTile(tile, data.data(), 16));
+    EXPECT_TRUE(store.readTile(tile, readData));
+    EXPECT_EQ(readData.size(), static_cast<size_t>(16));
+    EXPECT_TRUE(store.deleteTile(tile));
+    EXPECT_TRUE(store.readTile(tile, readData));
+    EXPECT_TRUE(readData.empty());
+
+    ds = nullptr;
+    VSIUnlink(path.c_str());
+    ngsUnInit();
+}
+
 TEST(DataStoreTests, TestDeleteDataStore) {
 	initLib();
 
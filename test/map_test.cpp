@@ -20,7 +20,10 @@
  ****************************************************************************/
 #include "test.h"
 // stl
+#include <chrono>
+#include <iostream>
 #include <memory>
+#include <set>
 
 #include "catalog/catalog.h"
 #include "catalog/folder.h"
@@ -28,6 +31,7 @@
 #include "ds/geometry.h"
 #include "map/gl/view.h"
 #include "map/mapstore.h"
+#include "map/maptransform.h"
 #include "map/mapview.h"
 #include "map/overlay.h"
 #include "ngstore/codes.h"
@@ -206,6 +210,82 @@ TEST(MapTests, TestInitMap) {
 }
 */
 
+TEST(MapTests, TestTilesForGeometry) {
+    const unsigned char zoom = 12;
+    double extraSize = ngs::DEFAULT_BOUNDS.width() / (1 << zoom) * 0.1;
+
+    // Long diagonal road
+    OGRLineString line;
+    for(int i = 0; i <= 100; ++i) {
+        line.addPoint(4000000.0 + i * 10000.0, 7000000.0 + i * 8000.0);
+    }
+    OGREnvelope ogrEnv;
+    line.getEnvelope(&ogrEnv);
+    ngs::Envelope extent(ogrEnv.MinX - extraSize, ogrEnv.MinY - extraSize,
+                         ogrEnv.MaxX + extraSize, ogrEnv.MaxY + extraSize);
+
+    auto extentTiles = ngs::MapTransform::getTilesForExtent(extent, zoom,
+                                                            false, true);
+    auto lineTiles = ngs::MapTransform::getTilesForGeometry(line, zoom,
+                                                            extraSize, true);
+    EXPECT_LT(lineTiles.size() * 10, extentTiles.size());
+
+    std::set<ngs::Tile> extentSet;
+    for(const auto &item : extentTiles) {
+        extentSet.insert(item.tile);
+    }
+    for(const auto &item : lineTiles) {
+        EXPECT_EQ(extentSet.count(item.tile), 1);
+    }
+
+    // Every tile with clipped geometry is in cover
+    ngs::GEOSGeometryWrap geosLine(&line);
+    std::set<ngs::Tile> lineSet;
+    for(const auto &item : lineTiles) {
+        lineSet.insert(item.tile);
+    }
+
+    auto clipAll = [&](const std::vector<ngs::TileItem> &tiles,
+                       std::set<ngs::Tile> &notEmpty) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for(const auto &item : tiles) {
+            ngs::VectorTileItemArray items;
+            ngs::GEOSGeometryPtr clip = geosLine.clip(item.env);
+            clip->fillTile(1, items);
+            if(!items.empty()) {
+                notEmpty.insert(item.tile);
+            }
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start).count();
+    };
+
+    std::set<ngs::Tile> extentNotEmpty, lineNotEmpty;
+    auto extentTime = clipAll(extentTiles, extentNotEmpty);
+    auto lineTime = clipAll(lineTiles, lineNotEmpty);
+    EXPECT_EQ(extentNotEmpty, lineNotEmpty);
+    std::cout << "Clip line by " << extentTiles.size() << " envelope tiles: "
+              << extentTime << " us, by " << lineTiles.size()
+              << " geometry tiles: " << lineTime << " us\n";
+
+    // Polygon interior tiles are covered too
+    OGRPolygon square;
+    OGRLinearRing *ring = new OGRLinearRing;
+    ring->addPoint(4000000.0, 7000000.0);
+    ring->addPoint(4200000.0, 7000000.0);
+    ring->addPoint(4200000.0, 7200000.0);
+    ring->addPoint(4000000.0, 7200000.0);
+    ring->addPoint(4000000.0, 7000000.0);
+    square.addRingDirectly(ring);
+    square.getEnvelope(&ogrEnv);
+    extent = ngs::Envelope(ogrEnv.MinX - extraSize, ogrEnv.MinY - extraSize,
+                           ogrEnv.MaxX + extraSize, ogrEnv.MaxY + extraSize);
+    EXPECT_EQ(ngs::MapTransform::getTilesForGeometry(square, zoom, extraSize,
+                                                     true).size(),
+              ngs::MapTransform::getTilesForExtent(extent, zoom, false,
+                                                   true).size());
+}
+
 /*
 TEST(MapTests, TestProject)
 {